@@ -0,0 +1,686 @@
+#include <tb_gui.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <fstream>
+#include <new>
+#include <thread>
+
+/*
+	Headless benchmark for the TurboGUI hot path. Creates a surfaceless EGL context (mesa llvmpipe works),
+	renders into an fbo and runs GUI::begin()/draw()/sync() over scripted workloads.
+
+	usage: tbgbench [--frames n] [--warmup n] [--width w] [--height h] [--frames-in-flight n] [--upload-threads n] [--list-cache] [--retained] [--damage] [--no-cull] [--quads] [--pace queued] [--gl-state persistent|restore] [--workload name] [--draw-mode direct,indirect,drawid] [--vertex-format float,packed] [--map-mode persistent,coherent,flush] [--copy memcpy,stream] [--copy-bench] [--pipeline depth] [--trace file] [--capture file [--check-replay]] [--replay file] [--program-cache dir] [--font-cache dir] [--fail-on-alloc] [--csv]
+*/
+
+static unsigned int g_glErrors = 0;
+
+//heap allocations of the calling thread. ImGui allocates through malloc and is not counted, everything
+//TurboGUI allocates goes through operator new. every form is replaced so none slips past the count and
+//every delete matches its new
+static thread_local unsigned long long t_allocs = 0;
+
+static void* countedAlloc(size_t _size, size_t _align) noexcept {
+	++t_allocs;
+	if (_size == 0) _size = 1;
+	if (_align <= alignof(std::max_align_t)) return std::malloc(_size);
+	//aligned_alloc wants a multiple of the alignment, its memory goes back through free
+	return std::aligned_alloc(_align, (_size + _align - 1) / _align * _align);
+}
+static void* countedNew(size_t _size, size_t _align) {
+	if (void* p = countedAlloc(_size, _align))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(size_t _size) { return countedNew(_size, 0); }
+void* operator new[](size_t _size) { return countedNew(_size, 0); }
+void* operator new(size_t _size, std::align_val_t _align) { return countedNew(_size, (size_t)_align); }
+void* operator new[](size_t _size, std::align_val_t _align) { return countedNew(_size, (size_t)_align); }
+void* operator new(size_t _size, const std::nothrow_t&) noexcept { return countedAlloc(_size, 0); }
+void* operator new[](size_t _size, const std::nothrow_t&) noexcept { return countedAlloc(_size, 0); }
+void* operator new(size_t _size, std::align_val_t _align, const std::nothrow_t&) noexcept { return countedAlloc(_size, (size_t)_align); }
+void* operator new[](size_t _size, std::align_val_t _align, const std::nothrow_t&) noexcept { return countedAlloc(_size, (size_t)_align); }
+
+void operator delete(void* _p) noexcept { std::free(_p); }
+void operator delete[](void* _p) noexcept { std::free(_p); }
+void operator delete(void* _p, size_t) noexcept { std::free(_p); }
+void operator delete[](void* _p, size_t) noexcept { std::free(_p); }
+void operator delete(void* _p, std::align_val_t) noexcept { std::free(_p); }
+void operator delete[](void* _p, std::align_val_t) noexcept { std::free(_p); }
+void operator delete(void* _p, size_t, std::align_val_t) noexcept { std::free(_p); }
+void operator delete[](void* _p, size_t, std::align_val_t) noexcept { std::free(_p); }
+void operator delete(void* _p, const std::nothrow_t&) noexcept { std::free(_p); }
+void operator delete[](void* _p, const std::nothrow_t&) noexcept { std::free(_p); }
+void operator delete(void* _p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(_p); }
+void operator delete[](void* _p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(_p); }
+
+void GLAPIENTRY MessageCallback(GLenum /*source*/, GLenum type, GLuint /*id*/, GLenum severity, GLsizei /*length*/, const GLchar* message, const void* /*userParam*/) {
+	if (type != GL_DEBUG_TYPE_ERROR) return;
+	++g_glErrors;
+	fprintf(stderr, "GL CALLBACK: ** GL ERROR ** type = 0x%x, severity = 0x%x, message = %s\n", type, severity, message);
+}
+
+struct Options {
+	unsigned int frames = 200;
+	unsigned int warmup = 20;
+	unsigned int width = 1920;
+	unsigned int height = 1080;
+	unsigned int framesInFlight = 2;
+	unsigned int uploadThreads = 0;
+	bool listCache = false;
+	bool retained = false;
+	bool damage = false;
+	bool cull = true;
+	bool quads = false;
+	//frame pacing with at most paceQueued frames ahead of the gpu, 0 is framesInFlight
+	bool pacing = false;
+	unsigned int paceQueued = 0;
+	bool persistentState = false;
+	bool restoreState = false;
+	std::string workload;
+	std::vector<TurboGUI::DrawMode> drawModes = { TurboGUI::DrawMode::Direct };
+	std::vector<TurboGUI::VertexFormat> vertexFormats = { TurboGUI::VertexFormat::Float };
+	std::vector<TurboGUI::MapMode> mapModes = { TurboGUI::MapMode::Persistent };
+	std::vector<bool> copies = std::vector<bool>(1, false);
+	bool copyBench = false;
+	//queue depth of the app thread -> render thread handoff, 0 runs both on one thread
+	unsigned int pipeline = 0;
+	//chrome trace of the last run
+	std::string trace;
+	//draw data of the last run, and a capture that replaces the workloads
+	std::string capture;
+	std::string replay;
+	//replay the capture of every run and exit with 4 if it uploads or draws other than the run
+	bool checkReplay = false;
+	//program binary and font atlas cache, the init time of every run goes to stderr
+	std::string programCache;
+	std::string fontCache;
+	//exit with 3 if a measured frame allocated in draw()/sync()
+	bool failOnAlloc = false;
+	bool csv = false;
+};
+
+struct Workload {
+	const char* name;
+	std::function<void(unsigned int)> run;
+};
+
+struct RunConfig {
+	TurboGUI::DrawMode mode;
+	TurboGUI::VertexFormat format;
+	TurboGUI::MapMode map;
+	bool stream;
+
+	//the draw mode plus everything that is not the default, e.g. "direct/packed/flush/stream"
+	std::string name() const;
+};
+
+struct Result {
+	std::vector<float> cpu; //ms
+	double bytes = 0.;
+	double draws = 0.;
+	double glCalls = 0.;
+	double sync = 0.; //ns
+	//cpu phases and gpu time, ms
+	double upload = 0.;
+	double submit = 0.;
+	double gpu = 0.;
+	//heap allocations in draw()/sync() over all measured frames
+	unsigned long long allocs = 0;
+};
+
+template<class T>
+using Names = std::vector<std::pair<const char*, T>>;
+
+static const Names<TurboGUI::DrawMode> drawModeNames = {
+	{ "direct", TurboGUI::DrawMode::Direct }, { "indirect", TurboGUI::DrawMode::Indirect }, { "drawid", TurboGUI::DrawMode::IndirectDrawID }
+};
+static const Names<TurboGUI::VertexFormat> vertexFormatNames = {
+	{ "float", TurboGUI::VertexFormat::Float }, { "packed", TurboGUI::VertexFormat::Packed }
+};
+static const Names<TurboGUI::MapMode> mapModeNames = {
+	{ "persistent", TurboGUI::MapMode::Persistent }, { "coherent", TurboGUI::MapMode::Coherent }, { "flush", TurboGUI::MapMode::ExplicitFlush }
+};
+static const Names<bool> copyNames = {
+	{ "memcpy", false }, { "stream", true }
+};
+
+template<class T>
+static const char* nameOf(const Names<T>& _names, T _value) {
+	for (const auto& n : _names)
+		if (n.second == _value) return n.first;
+	return "";
+}
+
+//comma separated list, e.g. "direct,indirect,drawid"
+template<class T>
+static bool parseList(const std::string& _list, const Names<T>& _names, std::vector<T>& _out) {
+	_out.clear();
+	size_t pos = 0;
+	while (pos <= _list.size()) {
+		const size_t end = std::min(_list.find(',', pos), _list.size());
+		const std::string name = _list.substr(pos, end - pos);
+		bool known = false;
+		for (const auto& n : _names) {
+			if (name != n.first) continue;
+			_out.push_back(n.second);
+			known = true;
+		}
+		if (!known) return false;
+		pos = end + 1;
+	}
+	return !_out.empty();
+}
+
+std::string RunConfig::name() const {
+	std::string out = nameOf(drawModeNames, mode);
+	if (format != TurboGUI::VertexFormat::Float) out += std::string("/") + nameOf(vertexFormatNames, format);
+	if (map != TurboGUI::MapMode::Persistent) out += std::string("/") + nameOf(mapModeNames, map);
+	if (stream) out += "/stream";
+	return out;
+}
+
+static bool parseGLState(const std::string& _name, Options& _opt) {
+	_opt.persistentState = _name == "persistent";
+	_opt.restoreState = _name == "restore";
+	return _opt.persistentState || _opt.restoreState;
+}
+
+static bool parseOptions(int argc, char** argv, Options& _opt) {
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (arg == "--frames" && hasValue) _opt.frames = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--warmup" && hasValue) _opt.warmup = std::max(0, std::atoi(argv[++i]));
+		else if (arg == "--width" && hasValue) _opt.width = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--height" && hasValue) _opt.height = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--frames-in-flight" && hasValue) _opt.framesInFlight = std::max(0, std::atoi(argv[++i]));
+		else if (arg == "--upload-threads" && hasValue) _opt.uploadThreads = std::max(0, std::atoi(argv[++i]));
+		else if (arg == "--list-cache") _opt.listCache = true;
+		else if (arg == "--retained") _opt.retained = true;
+		else if (arg == "--damage") _opt.damage = true;
+		else if (arg == "--no-cull") _opt.cull = false;
+		else if (arg == "--quads") _opt.quads = true;
+		else if (arg == "--pace" && hasValue) { _opt.pacing = true; _opt.paceQueued = std::max(0, std::atoi(argv[++i])); }
+		else if (arg == "--gl-state" && hasValue && parseGLState(argv[++i], _opt)) {}
+		else if (arg == "--workload" && hasValue) _opt.workload = argv[++i];
+		else if (arg == "--draw-mode" && hasValue && parseList(argv[++i], drawModeNames, _opt.drawModes)) {}
+		else if (arg == "--vertex-format" && hasValue && parseList(argv[++i], vertexFormatNames, _opt.vertexFormats)) {}
+		else if (arg == "--map-mode" && hasValue && parseList(argv[++i], mapModeNames, _opt.mapModes)) {}
+		else if (arg == "--copy" && hasValue && parseList(argv[++i], copyNames, _opt.copies)) {}
+		else if (arg == "--copy-bench") _opt.copyBench = true;
+		else if (arg == "--pipeline" && hasValue) _opt.pipeline = std::max(0, std::atoi(argv[++i]));
+		else if (arg == "--trace" && hasValue) _opt.trace = argv[++i];
+		else if (arg == "--capture" && hasValue) _opt.capture = argv[++i];
+		else if (arg == "--replay" && hasValue) _opt.replay = argv[++i];
+		else if (arg == "--check-replay") _opt.checkReplay = true;
+		else if (arg == "--program-cache" && hasValue) _opt.programCache = argv[++i];
+		else if (arg == "--font-cache" && hasValue) _opt.fontCache = argv[++i];
+		else if (arg == "--fail-on-alloc") _opt.failOnAlloc = true;
+		else if (arg == "--csv") _opt.csv = true;
+		else {
+			fprintf(stderr, "usage: %s [--frames n] [--warmup n] [--width w] [--height h] [--frames-in-flight n] [--upload-threads n] [--list-cache] [--retained] [--damage] [--no-cull] [--quads] [--pace queued] [--gl-state persistent|restore] [--workload name] [--draw-mode direct,indirect,drawid] [--vertex-format float,packed] [--map-mode persistent,coherent,flush] [--copy memcpy,stream] [--copy-bench] [--pipeline depth] [--trace file] [--capture file [--check-replay]] [--replay file] [--program-cache dir] [--font-cache dir] [--fail-on-alloc] [--csv]\n", argv[0]);
+			return false;
+		}
+	}
+	if (_opt.checkReplay && (_opt.capture.empty() || !_opt.replay.empty())) {
+		fprintf(stderr, "--check-replay needs --capture and no --replay\n");
+		return false;
+	}
+	return true;
+}
+
+static bool createContext(EGLDisplay& _display, EGLContext& _context) {
+	_display = EGL_NO_DISPLAY;
+
+	const char* clientExt = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (clientExt && std::strstr(clientExt, "EGL_MESA_platform_surfaceless")) {
+		auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay)
+			_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (_display == EGL_NO_DISPLAY)
+		_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (_display == EGL_NO_DISPLAY || !eglInitialize(_display, &major, &minor)) {
+		fprintf(stderr, "failed to initialize EGL\n");
+		return false;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		fprintf(stderr, "EGL has no desktop GL\n");
+		return false;
+	}
+
+	EGLConfig config = nullptr;
+	{
+		const EGLint attribs[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE
+		};
+		EGLint count = 0;
+		if (!eglChooseConfig(_display, attribs, &config, 1, &count) || count == 0)
+			config = nullptr; //EGL_KHR_no_config_context
+	}
+
+	const EGLint ctxAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+		EGL_NONE
+	};
+	_context = eglCreateContext(_display, config, EGL_NO_CONTEXT, ctxAttribs);
+	if (_context == EGL_NO_CONTEXT) {
+		fprintf(stderr, "failed to create a GL 4.3 core context (0x%x)\n", eglGetError());
+		return false;
+	}
+
+	//EGL_KHR_surfaceless_context
+	if (!eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _context)) {
+		fprintf(stderr, "failed to make the context current (0x%x)\n", eglGetError());
+		return false;
+	}
+	return true;
+}
+
+static std::vector<Workload> makeWorkloads() {
+	std::vector<Workload> out;
+
+	out.push_back({ "demo", [](unsigned int) {
+		ImGui::ShowDemoWindow();
+	} });
+
+	out.push_back({ "text", [](unsigned int _frame) {
+		const ImGuiIO& io = ImGui::GetIO();
+		ImDrawList* list = ImGui::GetForegroundDrawList();
+		char buf[128];
+		const unsigned int lines = 4000;
+		const unsigned int rows = std::max(1u, static_cast<unsigned int>(io.DisplaySize.y / 13.f));
+		for (unsigned int i = 0; i < lines; ++i) {
+			const float x = static_cast<float>((i / rows) * 190 % static_cast<unsigned int>(io.DisplaySize.x));
+			const float y = static_cast<float>(i % rows) * 13.f;
+			snprintf(buf, sizeof(buf), "line %u: frame %u lorem ipsum", i, _frame);
+			list->AddText(ImVec2(x, y), 0xFFFFFFFF, buf);
+		}
+	} });
+
+	out.push_back({ "table", [](unsigned int _frame) {
+		const ImGuiIO& io = ImGui::GetIO();
+		ImGui::SetNextWindowPos(ImVec2(0.f, 0.f));
+		ImGui::SetNextWindowSize(io.DisplaySize);
+		ImGui::Begin("table", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+		const int cols = 12;
+		if (ImGui::BeginTable("dense", cols, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			for (int row = 0; row < 200; ++row) {
+				ImGui::TableNextRow();
+				for (int col = 0; col < cols; ++col) {
+					ImGui::TableNextColumn();
+					ImGui::Text("%i:%i %u", row, col, (_frame + row * cols + col) % 1000);
+				}
+			}
+			ImGui::EndTable();
+		}
+		ImGui::End();
+	} });
+
+	out.push_back({ "windows", [](unsigned int _frame) {
+		const ImGuiIO& io = ImGui::GetIO();
+		char name[32];
+		//windows partially leave the screen and overlap each other to exercise the clipping path
+		for (unsigned int i = 0; i < 150; ++i) {
+			const float x = static_cast<float>((i * 97) % static_cast<unsigned int>(io.DisplaySize.x + 200)) - 100.f;
+			const float y = static_cast<float>((i * 61) % static_cast<unsigned int>(io.DisplaySize.y + 150)) - 75.f;
+			snprintf(name, sizeof(name), "window %u", i);
+			ImGui::SetNextWindowPos(ImVec2(x, y));
+			ImGui::SetNextWindowSize(ImVec2(220.f, 150.f));
+			ImGui::Begin(name);
+			for (unsigned int l = 0; l < 12; ++l)
+				ImGui::Text("item %u value %u", l, (_frame + l) % 97);
+			ImGui::End();
+		}
+	} });
+
+	return out;
+}
+
+static void addFrame(Result& _res, TurboGUI::GUI<>& _gui) {
+	_res.bytes += _gui.getUploadBytes();
+	_res.draws += _gui.getDrawCallCount();
+	_res.glCalls += _gui.getGLCallCount();
+	_res.sync += _gui.getSyncTime();
+	const TurboGUI::CpuPhases phases = _gui.getCpuPhases();
+	_res.upload += phases.upload;
+	_res.submit += phases.submit;
+	_res.gpu += _gui.getGpuTime();
+}
+
+static void average(Result& _res, unsigned int _frames) {
+	_res.bytes /= _frames;
+	_res.draws /= _frames;
+	_res.glCalls /= _frames;
+	_res.sync /= _frames;
+	_res.upload /= _frames;
+	_res.submit /= _frames;
+	_res.gpu /= _frames;
+}
+
+static Result runWorkload(TurboGUI::GUI<>& _gui, const Workload& _work, const Options& _opt) {
+	Result res;
+	res.cpu.reserve(_opt.frames);
+
+	for (unsigned int frame = 0; frame < _opt.warmup + _opt.frames; ++frame) {
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		const auto t = std::chrono::high_resolution_clock::now();
+		_gui.begin();
+		_work.run(frame);
+		const unsigned long long allocs = t_allocs;
+		_gui.draw();
+		_gui.sync();
+		const auto dt = std::chrono::high_resolution_clock::now() - t;
+
+		if (frame < _opt.warmup) continue;
+		res.cpu.push_back(static_cast<float>(std::chrono::duration<double, std::milli>(dt).count()));
+		res.allocs += t_allocs - allocs;
+		addFrame(res, _gui);
+	}
+	glFinish();
+
+	average(res, _opt.frames);
+	return res;
+}
+
+//the frames of a capture straight into draw(), looping if it is shorter than the run. cpu is draw() and sync()
+static Result runReplay(TurboGUI::GUI<>& _gui, TurboGUI::DrawReplay& _replay, const Options& _opt) {
+	Result res;
+	res.cpu.reserve(_opt.frames);
+
+	for (unsigned int frame = 0; frame < _opt.warmup + _opt.frames; ++frame) {
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		ImDrawData* data = _replay.frame(frame % _replay.getFrames());
+		const unsigned long long allocs = t_allocs;
+		const auto t = std::chrono::high_resolution_clock::now();
+		_gui.draw(data);
+		_gui.sync();
+		const auto dt = std::chrono::high_resolution_clock::now() - t;
+
+		if (frame < _opt.warmup) continue;
+		res.cpu.push_back(static_cast<float>(std::chrono::duration<double, std::milli>(dt).count()));
+		res.allocs += t_allocs - allocs;
+		addFrame(res, _gui);
+	}
+	glFinish();
+
+	average(res, _opt.frames);
+	return res;
+}
+
+//frames are built on a second thread and handed over through the snapshot queue. cpu is the frame time
+//of the app thread, everything else is measured here on the thread that owns the context
+static Result runPipelined(TurboGUI::GUI<>& _gui, const Workload& _work, const Options& _opt) {
+	Result res;
+	res.cpu.reserve(_opt.frames);
+	const unsigned int frames = _opt.warmup + _opt.frames;
+
+	std::thread app([&] {
+		for (unsigned int frame = 0; frame < frames; ++frame) {
+			const auto t = std::chrono::high_resolution_clock::now();
+			_gui.begin();
+			_work.run(frame);
+			_gui.submit();
+			const auto dt = std::chrono::high_resolution_clock::now() - t;
+			if (frame >= _opt.warmup)
+				res.cpu.push_back(static_cast<float>(std::chrono::duration<double, std::milli>(dt).count()));
+		}
+	});
+
+	for (unsigned int frame = 0; frame < frames; ++frame) {
+		glClear(GL_COLOR_BUFFER_BIT);
+		const unsigned long long allocs = t_allocs;
+		while (!_gui.drawQueued())
+			std::this_thread::yield();
+		if (frame < _opt.warmup) continue;
+		res.allocs += t_allocs - allocs;
+		addFrame(res, _gui);
+	}
+	app.join();
+	glFinish();
+
+	average(res, _opt.frames);
+	return res;
+}
+
+//the vertex copy in isolation: the vertices of one frame of a workload, memcpy against the packing kernel,
+//each with regular and streaming stores. host memory as destination, so the numbers do not depend on how
+//the driver maps the vbo
+static void runCopyBench(const Workload& _work, const Options& _opt) {
+	TurboGUI::GUI gui;
+	ImGui::SetCurrentContext(gui.getContext());
+	ImGuiIO& io = ImGui::GetIO();
+	io.IniFilename = nullptr;
+	io.DisplaySize = ImVec2(static_cast<float>(_opt.width), static_cast<float>(_opt.height));
+	io.DeltaTime = 1.f / 60.f;
+	io.Fonts->AddFontDefault();
+	unsigned char* pixels;
+	int w, h;
+	io.Fonts->GetTexDataAsAlpha8(&pixels, &w, &h);
+
+	ImGui::NewFrame();
+	_work.run(0);
+	ImGui::Render();
+	const ImDrawData* data = ImGui::GetDrawData();
+	std::vector<ImDrawVert> src;
+	for (int n = 0; n < data->CmdListsCount; ++n)
+		src.insert(src.end(), data->CmdLists[n]->VtxBuffer.begin(), data->CmdLists[n]->VtxBuffer.end());
+	if (src.empty()) return;
+
+	std::vector<ImDrawVert> plain(src.size());
+	std::vector<TurboGUI::PackedVert> packed(src.size());
+	auto time = [&](const std::function<void()>& _copy) {
+		for (unsigned int i = 0; i < _opt.warmup; ++i) _copy();
+		const auto t = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < _opt.frames; ++i) _copy();
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t).count() / _opt.frames;
+	};
+	const size_t bytes = src.size() * sizeof(ImDrawVert);
+	const double srcGB = bytes * 1e-6;
+	const auto report = [&](const char* _name, double _ms, size_t _written) {
+		printf("  %-14s %9.4f ms %7.2f GB/s read %9zu B written\n", _name, _ms, srcGB / _ms, _written);
+	};
+	printf("%s: %zu vertices\n", _work.name, src.size());
+	report("memcpy", time([&]() { std::memcpy(plain.data(), src.data(), bytes); }), bytes);
+	report("stream", time([&]() { TurboGUI::streamCopy(plain.data(), src.data(), bytes); }), bytes);
+	report("packed", time([&]() { TurboGUI::packVertices(packed.data(), src.data(), src.size()); }), src.size() * sizeof(TurboGUI::PackedVert));
+	report("packed/stream", time([&]() { TurboGUI::packVertices(packed.data(), src.data(), src.size(), true); }), src.size() * sizeof(TurboGUI::PackedVert));
+}
+
+static void printResult(const std::string& _name, Result& _res, bool _csv) {
+	std::sort(_res.cpu.begin(), _res.cpu.end());
+	const size_t n = _res.cpu.size();
+	const float mean = std::accumulate(_res.cpu.begin(), _res.cpu.end(), 0.f) / n;
+	const float p50 = _res.cpu[n / 2];
+	const float p95 = _res.cpu[std::min(n - 1, n * 95 / 100)];
+	const float max = _res.cpu[n - 1];
+
+	if (_csv)
+		printf("%s,%.4f,%.4f,%.4f,%.4f,%.0f,%.1f,%.1f,%.4f,%.4f,%.4f,%.4f,%llu\n", _name.c_str(), mean, p50, p95, max, _res.bytes, _res.draws, _res.glCalls, _res.sync * 1e-6, _res.upload, _res.submit, _res.gpu, _res.allocs);
+	else
+		printf("%-36s %9.3f %9.3f %9.3f %9.3f %12.0f %9.1f %9.1f %9.4f %9.3f %9.3f %9.3f %7llu\n", _name.c_str(), mean, p50, p95, max, _res.bytes, _res.draws, _res.glCalls, _res.sync * 1e-6, _res.upload, _res.submit, _res.gpu, _res.allocs);
+}
+
+int main(int argc, char** argv) {
+
+	Options opt;
+	if (!parseOptions(argc, argv, opt))
+		return 1;
+
+	EGLDisplay display;
+	EGLContext context;
+	if (!createContext(display, context))
+		return 1;
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+		fprintf(stderr, "failed to load GL\n");
+		return 1;
+	}
+
+	glEnable(GL_DEBUG_OUTPUT);
+	glDebugMessageCallback(MessageCallback, 0);
+
+	fprintf(stderr, "renderer: %s | %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+	//there is no default framebuffer on a surfaceless context
+	GLuint fbo, rbo;
+	glGenFramebuffers(1, &fbo);
+	glGenRenderbuffers(1, &rbo);
+	glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, opt.width, opt.height);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		fprintf(stderr, "incomplete framebuffer\n");
+		return 1;
+	}
+	glClearColor(0.f, 0.f, 0.4f, 1.f);
+
+	//a replay is the only workload, its frames do not run ImGui
+	TurboGUI::DrawReplay replay;
+	if (!opt.replay.empty() && (!replay.open(opt.replay) || replay.getFrames() == 0)) {
+		fprintf(stderr, "'%s' is no capture of this build\n", opt.replay.c_str());
+		return 1;
+	}
+	const std::vector<Workload> workloads = opt.replay.empty() ? makeWorkloads() : std::vector<Workload>{ { "replay", nullptr } };
+
+	if (opt.copyBench) {}
+	else if (opt.csv)
+		printf("workload,cpu_mean_ms,cpu_p50_ms,cpu_p95_ms,cpu_max_ms,upload_bytes,draw_calls,gl_calls,sync_ms,upload_ms,submit_ms,gpu_ms,allocs\n");
+	else
+		printf("%-36s %9s %9s %9s %9s %12s %9s %9s %9s %9s %9s %9s %7s\n", "workload", "mean[ms]", "p50[ms]", "p95[ms]", "max[ms]", "upload[B]", "draws", "gl", "sync[ms]", "upl[ms]", "sub[ms]", "gpu[ms]", "allocs");
+
+	//every combination of the listed modes
+	std::vector<RunConfig> runs;
+	for (TurboGUI::VertexFormat format : opt.vertexFormats)
+		for (TurboGUI::MapMode map : opt.mapModes)
+			for (bool stream : opt.copies)
+				for (TurboGUI::DrawMode mode : opt.drawModes)
+					runs.push_back({ mode, format, map, stream });
+
+	bool found = false;
+	bool allocFailed = false;
+	bool replayFailed = false;
+	for (const Workload& work : workloads) {
+		if (!opt.workload.empty() && opt.workload != work.name) continue;
+		found = true;
+
+		if (opt.copyBench) {
+			if (work.run)
+				runCopyBench(work, opt);
+			continue;
+		}
+
+		for (const RunConfig& run : runs) {
+			//fresh context per run so window state does not leak between runs
+			TurboGUI::GUI gui;
+			ImGui::SetCurrentContext(gui.getContext());
+			{
+				ImGuiIO& io = ImGui::GetIO();
+				io.IniFilename = nullptr;
+				io.DisplaySize = ImVec2(static_cast<float>(opt.width), static_cast<float>(opt.height));
+				io.DeltaTime = 1.f / 60.f;
+				io.Fonts->AddFontDefault();
+			}
+
+			if (opt.listCache)
+				gui.setListCache(1000000u, 2000000u);
+			gui.setVertexFormat(run.format);
+			gui.setMapMode(run.map);
+			if (!opt.programCache.empty())
+				gui.setProgramCache(opt.programCache);
+			if (!opt.fontCache.empty())
+				gui.setFontCache(opt.fontCache);
+			try {
+				gui.initGL(1000000u, 2000000u, opt.framesInFlight);
+			} catch (const TurboGUI::TurboGuiException& e) {
+				fprintf(stderr, "%s\n", e.what());
+				return 1;
+			}
+			if (!opt.programCache.empty() || !opt.fontCache.empty())
+				fprintf(stderr, "%s[%s]: init %.3f ms, %u programs from the cache, font %s\n", work.name, run.name().c_str(), gui.getInitTime(), gui.getProgramCacheHits(), gui.isFontFromCache() ? "from the cache" : "built");
+			gui.setDrawMode(run.mode);
+			gui.setStreamingCopy(run.stream);
+			gui.setGpuTiming(true);
+			if (!opt.trace.empty())
+				gui.setTraceCapture(opt.warmup + opt.frames);
+			if (!opt.capture.empty() && !gui.setDrawCapture(opt.capture)) {
+				fprintf(stderr, "failed to create '%s'\n", opt.capture.c_str());
+				return 1;
+			}
+			gui.setRetainedFrame(opt.retained);
+			gui.setDamageTracking(opt.damage);
+			gui.setCommandCulling(opt.cull);
+			gui.setQuadPulling(opt.quads);
+			gui.setFramePacing(opt.pacing);
+			gui.setMaxQueuedFrames(opt.paceQueued);
+			gui.setPersistentState(opt.persistentState);
+			gui.setRestoreState(opt.restoreState);
+			//threshold 0: measure the pool on every frame, not only on big ones
+			gui.setUploadThreads(opt.uploadThreads, 0);
+			//blocking, every frame gets drawn so the runs stay comparable
+			gui.setPipeline(opt.pipeline);
+
+			Result res = !work.run ? runReplay(gui, replay, opt) : opt.pipeline == 0 ? runWorkload(gui, work, opt) : runPipelined(gui, work, opt);
+			gui.setDrawCapture("");
+			std::string name = std::string(work.name) + "[" + run.name();
+			if (opt.pipeline != 0 && work.run) name += "/pipe" + std::to_string(opt.pipeline);
+			name += "]";
+			if (!opt.capture.empty() && gui.isDrawCaptureFailed()) {
+				fprintf(stderr, "failed to write '%s'\n", opt.capture.c_str());
+				return 1;
+			}
+			if (opt.checkReplay) {
+				//the same frames again from the file, through the same gui
+				TurboGUI::DrawReplay check;
+				const bool opened = check.open(opt.capture) && check.getFrames() == opt.warmup + opt.frames;
+				const Result again = opened ? runReplay(gui, check, opt) : Result();
+				if (!opened || again.bytes != res.bytes || again.draws != res.draws) {
+					fprintf(stderr, "%s: the replay differs from the run\n", name.c_str());
+					replayFailed = true;
+				}
+			}
+			if (!opt.trace.empty()) {
+				std::ofstream out(opt.trace);
+				gui.exportChromeTrace(out);
+			}
+			printResult(name, res, opt.csv);
+			if (res.allocs != 0) {
+				fprintf(stderr, "%s: %llu allocations in steady state frames\n", name.c_str(), res.allocs);
+				allocFailed = allocFailed || opt.failOnAlloc;
+			}
+		}
+	}
+
+	if (!found) {
+		fprintf(stderr, "unknown workload '%s'\n", opt.workload.c_str());
+		return 1;
+	}
+
+	glDeleteRenderbuffers(1, &rbo);
+	glDeleteFramebuffers(1, &fbo);
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(display, context);
+	eglTerminate(display);
+
+	if (g_glErrors != 0)
+		return 2;
+	return allocFailed ? 3 : replayFailed ? 4 : 0;
+}
@@ -175,12 +175,26 @@ int main() {
 		std::cout << e.what() << std::endl;
 	}
 
+	//frame pacing, toggled in the pacing window. with the swap interval at 0 the pacer caps the frame rate at
+	//the refresh rate of the primary monitor, if there is one, and starts frames late
+	bool pacing = false;
+	{
+		GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+		const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+		if (mode && mode->refreshRate > 0)
+			gui.setTargetFrameRate((float)mode->refreshRate);
+	}
+	gui.setDelayedBegin(true);
+
 	bool show_demo_window = true;
 
 	double time = glfwGetTime();
 	unsigned int frame = 0, fps = 0;
 	while (!glfwWindowShouldClose(window)) {
 
+		//before the input is polled, so the frame works with the latest input. returns at once without pacing
+		gui.waitForBegin();
+
 		double ctime = glfwGetTime();
 
 		glClearColor(0.f, 0.f, 0.4f, 1.f);
@@ -195,6 +209,11 @@ int main() {
 
 		gui.drawStatsWindow(fps);
 
+		ImGui::Begin("pacing");
+		if (ImGui::Checkbox("frame pacing", &pacing))
+			gui.setFramePacing(pacing);
+		ImGui::End();
+
 		gui.draw();
 		gui.sync();
 
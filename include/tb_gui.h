@@ -10,372 +10,5184 @@
 #include <algorithm>
 #include <numeric>
 #include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cmath>
+#include <climits>
+#include <unordered_map>
+#include <deque>
+#include <type_traits>
+#include <ostream>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TURBOGUI_SSE2
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define TURBOGUI_MMAP
+#elif defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
 
 #include <glad/glad.h>
 
-#include <imgui.h>
+#include <imgui.h>
+
+namespace TurboGUI {
+
+    typedef unsigned short ushort;
+    typedef unsigned int uint;
+
+	class TurboGuiException : public std::exception {
+		const std::string msg;
+	public:
+		TurboGuiException(std::string _msg) : msg(_msg) {};
+		virtual const char* what() const throw() {
+			return msg.c_str();
+		}
+	};
+
+	enum class DrawMode {
+		//one glScissor + glDrawElementsBaseVertex per ImDrawCmd
+		Direct,
+		//one glMultiDrawElementsIndirect per frame, clipping in the fragment shader. the clip rect is
+		//fetched through an instanced attribute indexed by baseInstance (GL 4.3)
+		Indirect,
+		//as Indirect, but the clip rect is looked up with gl_DrawIDARB. needs GL_ARB_shader_draw_parameters,
+		//falls back to Indirect without it
+		IndirectDrawID
+	};
+
+	enum class VertexFormat {
+		//ImDrawVert as is, 20 bytes
+		Float,
+		//PackedVert, 12 bytes. positions are snapped to 1/PackedPosScale pixels and clamped to +-8191,
+		//uvs to [0, 1] (no repeating image uvs)
+		Packed
+	};
+
+	enum class MapMode {
+		//persistent, unsynchronized mapping without coherent bit or flushes. what most drivers treat as
+		//coherent anyway
+		Persistent,
+		//GL_MAP_COHERENT_BIT, writes become visible without any call
+		Coherent,
+		//GL_MAP_FLUSH_EXPLICIT_BIT, only the bytes written are flushed with glFlushMappedBufferRange
+		ExplicitFlush
+	};
+
+	enum class PlotMode {
+		//a line strip through the samples
+		Lines,
+		//the area between the samples and the bottom of the range
+		Area
+	};
+
+	//cpu time of the last frame in ms
+	struct CpuPhases {
+		//begin() to the end of ImGui::Render()
+		float imgui = 0.f;
+		//hashing, list cache and copying the lists into the mapped buffers
+		float upload = 0.f;
+		//everything else in draw(): state, records and gl calls
+		float submit = 0.f;
+		//blocked on fences in draw() and sync()
+		float sync = 0.f;
+	};
+
+	//frame pacing, see GUI::setFramePacing()
+	struct PacingStats {
+		//begin() until the gpu finished the frame, as far as the fences tell. ms
+		float latency = 0.f;
+		//predicted time from the fence in sync() until the gpu passes it. ms
+		float gpu = 0.f;
+		//begin() until sync(), averaged. ms
+		float cpu = 0.f;
+		//how sync() waited for the gpu since initGL
+		uint polls = 0, sleeps = 0, blocks = 0;
+	};
+
+	//percentiles of one metric since the last resetMetrics()
+	struct MetricStats {
+		uint64_t count = 0;
+		float mean = 0.f, p50 = 0.f, p95 = 0.f, p99 = 0.f, max = 0.f;
+	};
+
+	struct MetricsSnapshot {
+		//frames recorded
+		uint64_t frames = 0;
+		MetricStats drawTime; //ms, begin() to the end of draw()
+		MetricStats syncTime; //ms
+		MetricStats uploadBytes;
+		MetricStats drawCalls;
+		//last frame
+		CpuPhases phases;
+		float gpuTime = 0.f;
+	};
+
+	//a damaged part of the framebuffer in pixels, lower left origin like glScissor and eglSwapBuffersWithDamageKHR
+	struct DamageRect {
+		int x, y, width, height;
+	};
+
+	//log-linear histogram with Sub buckets per power of two in [2^MinExp, 2^MaxExp). record() is constant time,
+	//a percentile is off by less than 1/Sub of its value. values below the range land in the first bucket,
+	//above in the last one
+	class Histogram {
+	public:
+		static constexpr int MinExp = -10, MaxExp = 32, Sub = 16;
+		static constexpr int Buckets = (MaxExp - MinExp) * Sub;
+
+		void record(double _v) {
+			int e = 0;
+			const double m = std::frexp(_v, &e); //_v = m * 2^e, m in [0.5, 1)
+			int i = 0;
+			if (_v > 0.)
+				i = std::min(std::max((e - 1 - MinExp) * Sub + static_cast<int>((m * 2. - 1.) * Sub), 0), Buckets - 1);
+			++counts[i];
+			++count;
+			sum += _v;
+			max = std::max(max, _v);
+		}
+
+		void reset() {
+			std::memset(counts, 0, sizeof(counts));
+			count = 0;
+			sum = 0.;
+			max = 0.;
+		}
+
+		//p50, p95 and p99 in one pass. the upper bound of the bucket, clamped to the maximum
+		MetricStats stats() const {
+			MetricStats out;
+			out.count = count;
+			if (count == 0) return out;
+			out.mean = static_cast<float>(sum / count);
+			out.max = static_cast<float>(max);
+			const double ranks[3] = { std::ceil(count * 0.5), std::ceil(count * 0.95), std::ceil(count * 0.99) };
+			float* targets[3] = { &out.p50, &out.p95, &out.p99 };
+			uint64_t seen = 0;
+			int r = 0;
+			for (int i = 0; i < Buckets && r < 3; ++i) {
+				seen += counts[i];
+				while (r < 3 && seen >= ranks[r]) {
+					const double upper = std::ldexp(1. + double(i % Sub + 1) / Sub, i / Sub + MinExp);
+					*targets[r++] = static_cast<float>(std::min(upper, max));
+				}
+			}
+			return out;
+		}
+
+	private:
+		uint32_t counts[Buckets] = {};
+		uint64_t count = 0;
+		double sum = 0., max = 0.;
+	};
+
+	//single writer, any number of readers. readers retry while a store is in progress and never block the writer
+	template<class T>
+	class SeqLock {
+		static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+		static constexpr size_t Words = (sizeof(T) + 7) / 8;
+		std::atomic<uint32_t> seq{ 0 };
+		std::atomic<uint64_t> words[Words];
+
+	public:
+		SeqLock() {
+			store(T());
+		}
+
+		void store(const T& _value) {
+			uint64_t buf[Words] = {};
+			std::memcpy(buf, &_value, sizeof(T));
+			const uint32_t s = seq.load(std::memory_order_relaxed);
+			seq.store(s + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			for (size_t i = 0; i < Words; ++i)
+				words[i].store(buf[i], std::memory_order_relaxed);
+			seq.store(s + 2, std::memory_order_release);
+		}
+
+		T load() const {
+			uint64_t buf[Words];
+			uint32_t s0, s1;
+			do {
+				s0 = seq.load(std::memory_order_acquire);
+				for (size_t i = 0; i < Words; ++i)
+					buf[i] = words[i].load(std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				s1 = seq.load(std::memory_order_relaxed);
+			} while ((s0 & 1) != 0 || s0 != s1);
+			T out;
+			std::memcpy(&out, buf, sizeof(T));
+			return out;
+		}
+	};
+
+	//minimal fork-join pool. run() hands out indices [0, count) to the workers and the calling thread
+	//and returns once every index was processed
+	class WorkerPool {
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable wake, done;
+
+		void (*job)(void*, uint) = nullptr;
+		void* jobData = nullptr;
+		uint jobCount = 0;
+		std::atomic<uint> next{ 0 };
+
+		uint generation = 0;
+		uint arrived = 0;
+		bool quit = false;
+
+		void work() {
+			for (uint i = next.fetch_add(1); i < jobCount; i = next.fetch_add(1))
+				job(jobData, i);
+		}
+
+		void loop() {
+			uint seen = 0;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [&] { return quit || generation != seen; });
+					if (quit) return;
+					seen = generation;
+				}
+				work();
+				{
+					//every worker checks in once per run, so none of them can still read the job afterwards
+					std::lock_guard<std::mutex> lock(mutex);
+					if (++arrived == threads.size())
+						done.notify_one();
+				}
+			}
+		}
+
+	public:
+		explicit WorkerPool(uint _threads) {
+			for (uint i = 0; i < _threads; ++i)
+				threads.emplace_back([this] { loop(); });
+		}
+
+		~WorkerPool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				quit = true;
+			}
+			wake.notify_all();
+			for (std::thread& t : threads)
+				t.join();
+		}
+
+		uint size() const { return static_cast<uint>(threads.size()) + 1; }
+
+		template<class F>
+		void run(uint _count, F& _fn) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				job = [](void* _data, uint _i) { (*static_cast<F*>(_data))(_i); };
+				jobData = &_fn;
+				jobCount = _count;
+				next = 0;
+				arrived = 0;
+				++generation;
+			}
+			wake.notify_all();
+			work();
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [&] { return arrived == threads.size(); });
+		}
+	};
+
+	//deep copy of an ImDrawData. the lists are kept between captures and only grow, so a warmed up snapshot
+	//copies without allocating
+	class DrawDataSnapshot {
+		std::vector<ImDrawList*> lists;
+		//the lists the copies were made from. the list cache and the damage tracking key on them
+		std::vector<const ImDrawList*> sources;
+		ImDrawData data;
+
+		template<class T>
+		static void copy(ImVector<T>& _dst, const ImVector<T>& _src) {
+			_dst.resize(_src.Size);
+			if (_src.Size != 0)
+				std::memcpy(_dst.Data, _src.Data, _src.size_in_bytes());
+		}
+
+	public:
+		//begin() and the end of ImGui::Render() on the thread that built the frame
+		std::chrono::high_resolution_clock::time_point beginTime, renderTime;
+
+		DrawDataSnapshot() = default;
+		DrawDataSnapshot(const DrawDataSnapshot&) = delete;
+		DrawDataSnapshot& operator=(const DrawDataSnapshot&) = delete;
+		~DrawDataSnapshot() {
+			for (ImDrawList* l : lists)
+				IM_DELETE(l);
+		}
+
+		void capture(const ImDrawData* _src) {
+			while (lists.size() < (size_t)_src->CmdListsCount)
+				lists.push_back(IM_NEW(ImDrawList)(nullptr));
+			for (int n = 0; n < _src->CmdListsCount; ++n) {
+				const ImDrawList* src = _src->CmdLists[n];
+				ImDrawList* dst = lists[n];
+				copy(dst->CmdBuffer, src->CmdBuffer);
+				copy(dst->IdxBuffer, src->IdxBuffer);
+				copy(dst->VtxBuffer, src->VtxBuffer);
+				dst->Flags = src->Flags;
+			}
+			sources.assign(_src->CmdLists, _src->CmdLists + _src->CmdListsCount);
+			data = *_src;
+			data.CmdLists = lists.data();
+		}
+
+		ImDrawData* get() { return &data; }
+		const ImDrawList* const* keys() const { return sources.data(); }
+	};
+
+	enum class Backpressure {
+		//the producer waits for a free slot
+		Block,
+		//the oldest queued frame is dropped
+		DropOldest
+	};
+
+	//lock-free single producer / single consumer queue of draw data snapshots. depth + 2 slots: up to depth
+	//queued, one the consumer still reads and one the producer writes, so dropping never touches a slot in use
+	class SnapshotQueue {
+		static constexpr uint None = ~0u;
+		//depth queued, one rendering, one being captured
+		std::vector<DrawDataSnapshot> slots;
+		const uint depth;
+		const Backpressure policy;
+		//slot indices, producer -> consumer
+		std::unique_ptr<std::atomic<uint>[]> ready;
+		alignas(64) std::atomic<uint64_t> head{ 0 };
+		alignas(64) std::atomic<uint64_t> tail{ 0 };
+		//released slot indices, consumer -> producer
+		std::unique_ptr<std::atomic<uint>[]> released;
+		alignas(64) std::atomic<uint64_t> releaseHead{ 0 };
+		alignas(64) std::atomic<uint64_t> releaseTail{ 0 };
+		std::atomic<uint64_t> dropped{ 0 };
+		//producer owned
+		std::vector<uint> spare;
+		//consumer owned
+		uint held = None;
+
+	public:
+		SnapshotQueue(uint _depth, Backpressure _policy) : slots(_depth + 2), depth(_depth), policy(_policy),
+			ready(new std::atomic<uint>[_depth]), released(new std::atomic<uint>[_depth + 2]) {
+			spare.reserve(slots.size());
+			for (uint i = 0; i < slots.size(); ++i)
+				spare.push_back(i);
+		}
+
+		//producer
+		void push(const ImDrawData* _data, std::chrono::high_resolution_clock::time_point _begin) {
+			const uint64_t h = head.load(std::memory_order_relaxed);
+			for (;;) {
+				uint64_t t = tail.load(std::memory_order_acquire);
+				if (h - t < depth) break;
+				if (policy == Backpressure::Block) {
+					std::this_thread::yield();
+					continue;
+				}
+				//loses against a concurrent pop, then there is room anyway
+				const uint idx = ready[t % depth].load(std::memory_order_relaxed);
+				if (tail.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel)) {
+					spare.push_back(idx);
+					dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+			for (;;) {
+				const uint64_t rh = releaseHead.load(std::memory_order_acquire);
+				uint64_t rt = releaseTail.load(std::memory_order_relaxed);
+				for (; rt != rh; ++rt)
+					spare.push_back(released[rt % slots.size()].load(std::memory_order_relaxed));
+				releaseTail.store(rt, std::memory_order_release);
+				if (!spare.empty()) break;
+				//the consumer is between taking a new slot and handing back the old one
+				std::this_thread::yield();
+			}
+			const uint idx = spare.back();
+			spare.pop_back();
+			DrawDataSnapshot& slot = slots[idx];
+			slot.capture(_data);
+			slot.beginTime = _begin;
+			slot.renderTime = std::chrono::high_resolution_clock::now();
+			ready[h % depth].store(idx, std::memory_order_relaxed);
+			head.store(h + 1, std::memory_order_release);
+		}
+
+		//consumer. the snapshot stays valid until the next pop()
+		DrawDataSnapshot* pop() {
+			uint64_t t = tail.load(std::memory_order_acquire);
+			uint idx;
+			for (;;) {
+				if (t == head.load(std::memory_order_acquire)) return nullptr;
+				idx = ready[t % depth].load(std::memory_order_relaxed);
+				if (tail.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel)) break;
+			}
+			if (held != None) {
+				const uint64_t rh = releaseHead.load(std::memory_order_relaxed);
+				released[rh % slots.size()].store(held, std::memory_order_relaxed);
+				releaseHead.store(rh + 1, std::memory_order_release);
+			}
+			held = idx;
+			return &slots[idx];
+		}
+
+		uint size() const { return static_cast<uint>(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire)); }
+		uint64_t droppedFrames() const { return dropped.load(std::memory_order_relaxed); }
+	};
+
+	//first-fit allocator over [0, capacity). neighbouring free blocks are merged on release
+	class ArenaAllocator {
+		struct Block {
+			uint begin, size;
+		};
+		std::vector<Block> blocks;
+
+	public:
+		void reset(uint _capacity) {
+			blocks.clear();
+			if (_capacity != 0)
+				blocks.push_back({ 0, _capacity });
+		}
+
+		bool alloc(uint _size, uint& _offset) {
+			for (size_t i = 0; i < blocks.size(); ++i) {
+				Block& b = blocks[i];
+				if (b.size < _size) continue;
+				_offset = b.begin;
+				b.begin += _size;
+				b.size -= _size;
+				if (b.size == 0)
+					blocks.erase(blocks.begin() + i);
+				return true;
+			}
+			return false;
+		}
+
+		void release(uint _offset, uint _size) {
+			if (_size == 0) return;
+			auto it = std::lower_bound(blocks.begin(), blocks.end(), _offset, [](const Block& _b, uint _o) { return _b.begin < _o; });
+			it = blocks.insert(it, { _offset, _size });
+			if (it + 1 != blocks.end() && it->begin + it->size == (it + 1)->begin) {
+				it->size += (it + 1)->size;
+				blocks.erase(it + 1);
+			}
+			if (it != blocks.begin() && (it - 1)->begin + (it - 1)->size == it->begin) {
+				(it - 1)->size += it->size;
+				blocks.erase(it);
+			}
+		}
+	};
+
+	//word-at-a-time hash, good enough to tell two frames of the same list apart
+	inline uint64_t hashBytes(const void* _data, size_t _size, uint64_t _seed) {
+		const auto mix = [](uint64_t _h, uint64_t _v) {
+			_h ^= _v * 0xBF58476D1CE4E5B9ull;
+			_h = (_h << 31) | (_h >> 33);
+			return _h * 0x94D049BB133111EBull;
+		};
+		const unsigned char* p = static_cast<const unsigned char*>(_data);
+		uint64_t h0 = _seed ^ (_size * 0x9E3779B97F4A7C15ull), h1 = ~_seed, h2 = _seed + 0x9E3779B97F4A7C15ull, h3 = _seed - 0x9E3779B97F4A7C15ull;
+		size_t i = 0;
+		//four independent lanes keep the multiplies in flight
+		for (; i + 32 <= _size; i += 32) {
+			uint64_t v[4];
+			std::memcpy(v, p + i, 32);
+			h0 = mix(h0, v[0]);
+			h1 = mix(h1, v[1]);
+			h2 = mix(h2, v[2]);
+			h3 = mix(h3, v[3]);
+		}
+		for (; i + 8 <= _size; i += 8) {
+			uint64_t v;
+			std::memcpy(&v, p + i, 8);
+			h0 = mix(h0, v);
+		}
+		if (i < _size) {
+			uint64_t v = 0;
+			std::memcpy(&v, p + i, _size - i);
+			h1 = mix(h1, v);
+		}
+		uint64_t h = h0 ^ mix(h1, h2) ^ mix(h3, _size);
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	//hash over everything that ends up on the gpu or steers a draw of the list
+	inline uint64_t hashDrawList(const ImDrawList* _list) {
+		uint64_t h = hashBytes(_list->VtxBuffer.Data, _list->VtxBuffer.Size * sizeof(ImDrawVert), 0);
+		h = hashBytes(_list->IdxBuffer.Data, _list->IdxBuffer.Size * sizeof(ImDrawIdx), h);
+		for (const ImDrawCmd& cmd : _list->CmdBuffer) {
+			const uint counts[3] = { cmd.VtxOffset, cmd.IdxOffset, cmd.ElemCount };
+			h = hashBytes(&cmd.ClipRect, sizeof(ImVec4), h);
+			h = hashBytes(&cmd.TextureId, sizeof(ImTextureID), h);
+			h = hashBytes(counts, sizeof(counts), h);
+			h = hashBytes(&cmd.UserCallback, sizeof(ImDrawCallback), h);
+			h = hashBytes(&cmd.UserCallbackData, sizeof(void*), h);
+		}
+		return h;
+	}
+
+	constexpr float PackedPosScale = 4.f;
+
+	struct PackedVert {
+		int16_t pos[2]; //fixed point, PackedPosScale steps per pixel
+		uint16_t uv[2]; //unorm
+		ImU32 col;
+	};
+	static_assert(sizeof(PackedVert) == 12, "PackedVert must be tightly packed");
+
+	//an axis aligned quad as the quad programs pull it: two corners in PackedVert fixed point, their uvs and
+	//one color
+	struct PackedQuad {
+		int16_t a[2], c[2];
+		uint16_t uva[2], uvc[2];
+		ImU32 col;
+	};
+	static_assert(sizeof(PackedQuad) == 20, "PackedQuad must be tightly packed");
+
+	//true if the 6 indices at _idx are a quad as ImDrawList::PrimRectUV writes it: corners 0 1 2 0 2 3 of four
+	//vertices in a row, axis aligned in position and uv, one color. quads outside the PackedVert range stay
+	//triangles
+	inline bool isQuad(const ImDrawIdx* _idx, const ImDrawVert* _vtx) {
+		const uint i = _idx[0];
+		if (_idx[1] != i + 1 || _idx[2] != i + 2 || _idx[3] != i || _idx[4] != i + 2 || _idx[5] != i + 3)
+			return false;
+		const ImDrawVert& a = _vtx[i];
+		const ImDrawVert& b = _vtx[i + 1];
+		const ImDrawVert& c = _vtx[i + 2];
+		const ImDrawVert& d = _vtx[i + 3];
+		const float limit = 32767.f / PackedPosScale;
+		return b.pos.x == c.pos.x && b.pos.y == a.pos.y && d.pos.x == a.pos.x && d.pos.y == c.pos.y
+			&& b.uv.x == c.uv.x && b.uv.y == a.uv.y && d.uv.x == a.uv.x && d.uv.y == c.uv.y
+			&& a.col == b.col && a.col == c.col && a.col == d.col
+			&& std::fabs(a.pos.x) <= limit && std::fabs(a.pos.y) <= limit && std::fabs(c.pos.x) <= limit && std::fabs(c.pos.y) <= limit
+			&& a.uv.x >= 0.f && a.uv.y >= 0.f && c.uv.x >= 0.f && c.uv.y >= 0.f
+			&& a.uv.x <= 1.f && a.uv.y <= 1.f && c.uv.x <= 1.f && c.uv.y <= 1.f;
+	}
+
+	//_count quads starting at _idx, rounded like packVertices
+	inline void packQuads(PackedQuad* _dst, const ImDrawIdx* _idx, const ImDrawVert* _vtx, uint _count) {
+		for (uint q = 0; q < _count; ++q, _idx += 6) {
+			const ImDrawVert& a = _vtx[_idx[0]];
+			const ImDrawVert& c = _vtx[_idx[2]];
+			PackedQuad& o = _dst[q];
+			o.a[0] = static_cast<int16_t>(std::nearbyint(a.pos.x * PackedPosScale));
+			o.a[1] = static_cast<int16_t>(std::nearbyint(a.pos.y * PackedPosScale));
+			o.c[0] = static_cast<int16_t>(std::nearbyint(c.pos.x * PackedPosScale));
+			o.c[1] = static_cast<int16_t>(std::nearbyint(c.pos.y * PackedPosScale));
+			o.uva[0] = static_cast<uint16_t>(std::nearbyint(a.uv.x * 65535.f));
+			o.uva[1] = static_cast<uint16_t>(std::nearbyint(a.uv.y * 65535.f));
+			o.uvc[0] = static_cast<uint16_t>(std::nearbyint(c.uv.x * 65535.f));
+			o.uvc[1] = static_cast<uint16_t>(std::nearbyint(c.uv.y * 65535.f));
+			o.col = a.col;
+		}
+	}
+
+	//memcpy with non-temporal stores, the destination does not end up in the cache. meant for write combined
+	//memory that is never read back by the cpu
+	inline void streamCopy(void* _dst, const void* _src, size_t _bytes) {
+#ifdef TURBOGUI_SSE2
+		char* dst = static_cast<char*>(_dst);
+		const char* src = static_cast<const char*>(_src);
+		const size_t head = std::min(_bytes, (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15);
+		std::memcpy(dst, src, head);
+		size_t i = head;
+		for (; i + 64 <= _bytes; i += 64) {
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+			const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 32));
+			const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 48));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), a);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 16), b);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 32), c);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 48), d);
+		}
+		for (; i + 16 <= _bytes; i += 16)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+		std::memcpy(dst + i, src + i, _bytes - i);
+		//streaming stores are weakly ordered, they have to land before the fence sync of the frame
+		_mm_sfence();
+#else
+		std::memcpy(_dst, _src, _bytes);
+#endif
+	}
+
+	//converts _count vertices. the sse2 path does 4 vertices per iteration, 80 bytes in and three 16 byte
+	//stores out. rounding is to nearest even on both paths. _stream writes with non-temporal stores
+	inline void packVertices(PackedVert* _dst, const ImDrawVert* _src, size_t _count, bool _stream = false) {
+		size_t i = 0;
+#ifdef TURBOGUI_SSE2
+		//every 4th vertex starts on a 16 byte boundary, the ones before that go through the scalar path
+		if (_stream) {
+			while (i < _count && (reinterpret_cast<uintptr_t>(_dst + i) & 15) != 0) ++i;
+			if ((reinterpret_cast<uintptr_t>(_dst + i) & 15) != 0) {
+				i = 0;
+				_stream = false;
+			}
+			packVertices(_dst, _src, i);
+		}
+		const __m128 scale = _mm_setr_ps(PackedPosScale, PackedPosScale, 65535.f, 65535.f);
+		const __m128 lo = _mm_setr_ps(-32768.f, -32768.f, 0.f, 0.f);
+		const __m128 hi = _mm_setr_ps(32767.f, 32767.f, 65535.f, 65535.f);
+		//uvs go through the signed pack with a bias of 32768 that is flipped back afterwards
+		const __m128i bias = _mm_setr_epi32(0, 0, 32768, 32768);
+		const __m128i flip = _mm_setr_epi16(0, 0, -32768, -32768, 0, 0, -32768, -32768);
+		auto convert = [&](const ImDrawVert& _v) {
+			const __m128 f = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&_v.pos.x), scale), lo), hi);
+			return _mm_sub_epi32(_mm_cvtps_epi32(f), bias);
+		};
+		char* out = reinterpret_cast<char*>(_dst);
+		for (; i + 4 <= _count; i += 4) {
+			const ImDrawVert* v = _src + i;
+			//dwords: p01 = [a0 a1 b0 b1], p23 = [c0 c1 d0 d1], one vertex is two dwords plus its color
+			const __m128i p01 = _mm_xor_si128(_mm_packs_epi32(convert(v[0]), convert(v[1])), flip);
+			const __m128i p23 = _mm_xor_si128(_mm_packs_epi32(convert(v[2]), convert(v[3])), flip);
+			const __m128i cols = _mm_setr_epi32((int)v[0].col, (int)v[1].col, (int)v[2].col, (int)v[3].col);
+			const __m128i x = _mm_unpacklo_epi32(cols, _mm_shuffle_epi32(p01, _MM_SHUFFLE(3, 2, 3, 2))); //[col0 b0 col1 b1]
+			const __m128i y = _mm_unpackhi_epi32(cols, p23); //[col2 d0 col3 d1]
+			const __m128 out0 = _mm_shuffle_ps(_mm_castsi128_ps(p01), _mm_castsi128_ps(x), _MM_SHUFFLE(1, 0, 1, 0));
+			const __m128 out1 = _mm_shuffle_ps(_mm_castsi128_ps(x), _mm_castsi128_ps(p23), _MM_SHUFFLE(1, 0, 2, 3));
+			const __m128i out2 = _mm_shuffle_epi32(y, _MM_SHUFFLE(2, 3, 1, 0));
+			if (_stream) {
+				_mm_stream_ps(reinterpret_cast<float*>(out + i * 12), out0);
+				_mm_stream_ps(reinterpret_cast<float*>(out + i * 12 + 16), out1);
+				_mm_stream_si128(reinterpret_cast<__m128i*>(out + i * 12 + 32), out2);
+			} else {
+				_mm_storeu_ps(reinterpret_cast<float*>(out + i * 12), out0);
+				_mm_storeu_ps(reinterpret_cast<float*>(out + i * 12 + 16), out1);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 12 + 32), out2);
+			}
+		}
+		if (_stream)
+			_mm_sfence();
+#endif
+		for (; i < _count; ++i) {
+			const ImDrawVert& v = _src[i];
+			PackedVert& o = _dst[i];
+			o.pos[0] = static_cast<int16_t>(std::nearbyint(std::min(std::max(v.pos.x * PackedPosScale, -32768.f), 32767.f)));
+			o.pos[1] = static_cast<int16_t>(std::nearbyint(std::min(std::max(v.pos.y * PackedPosScale, -32768.f), 32767.f)));
+			o.uv[0] = static_cast<uint16_t>(std::nearbyint(std::min(std::max(v.uv.x * 65535.f, 0.f), 65535.f)));
+			o.uv[1] = static_cast<uint16_t>(std::nearbyint(std::min(std::max(v.uv.y * 65535.f, 0.f), 65535.f)));
+			o.col = v.col;
+		}
+	}
+
+	//bump allocator for scratch memory that lives for one frame. reset() keeps the memory, allocations that
+	//did not fit go to overflow blocks and are merged into one block on the next reset, so a frame only
+	//allocates while it is bigger than every frame before it
+	class FrameArena {
+		static constexpr size_t Align = 64;
+		std::unique_ptr<unsigned char[]> block;
+		size_t capacity = 0;
+		size_t used = 0;
+		std::vector<std::unique_ptr<unsigned char[]>> overflow;
+		size_t overflowBytes = 0;
+
+		static unsigned char* align(unsigned char* _p) {
+			return reinterpret_cast<unsigned char*>((reinterpret_cast<uintptr_t>(_p) + Align - 1) & ~(uintptr_t)(Align - 1));
+		}
+
+	public:
+		template<class T>
+		T* alloc(size_t _count) {
+			static_assert(std::is_trivially_destructible<T>::value, "the arena never runs destructors");
+			const size_t bytes = (_count * sizeof(T) + Align - 1) & ~(Align - 1);
+			if (used + bytes <= capacity) {
+				T* out = reinterpret_cast<T*>(align(block.get()) + used);
+				used += bytes;
+				return out;
+			}
+			overflow.emplace_back(new unsigned char[bytes + Align]);
+			overflowBytes += bytes;
+			return reinterpret_cast<T*>(align(overflow.back().get()));
+		}
+
+		void reset() {
+			if (!overflow.empty()) {
+				capacity = used + overflowBytes;
+				block.reset(new unsigned char[capacity + Align]);
+				overflow.clear();
+				overflowBytes = 0;
+			}
+			used = 0;
+		}
+
+		size_t size() const { return capacity; }
+	};
+
+	//the commands of one chunk as structure of arrays. the clip pass reads and writes contiguous lanes
+	struct CommandList {
+		uint size = 0;
+		//ImDrawCmd::ClipRect
+		float* clipX0, *clipY0, *clipX1, *clipY1;
+		//scissor in window coordinates and the visibility, written by clipCommands()
+		int* x, *y, *width, *height;
+		uint8_t* visible;
+		uint* elemCount;
+		//into the storage, the list offsets are already applied
+		uint* firstIndex;
+		GLint* baseVertex;
+		ImTextureID* texture;
+		//the geometry in the source list, the vertex offset is applied
+		const ImDrawIdx** srcIdx;
+		const ImDrawVert** srcVtx;
+		//ImDrawCmd::UserCallback commands and their list, null for geometry
+		const ImDrawCmd** callback;
+		const ImDrawList** parent;
+		//runs of pulled quads. firstIndex and elemCount count their vertices, 6 per quad
+		uint8_t* quad;
+
+		void allocate(FrameArena& _arena, uint _size) {
+			size = _size;
+			clipX0 = _arena.alloc<float>(_size);
+			clipY0 = _arena.alloc<float>(_size);
+			clipX1 = _arena.alloc<float>(_size);
+			clipY1 = _arena.alloc<float>(_size);
+			x = _arena.alloc<int>(_size);
+			y = _arena.alloc<int>(_size);
+			width = _arena.alloc<int>(_size);
+			height = _arena.alloc<int>(_size);
+			visible = _arena.alloc<uint8_t>(_size);
+			elemCount = _arena.alloc<uint>(_size);
+			firstIndex = _arena.alloc<uint>(_size);
+			baseVertex = _arena.alloc<GLint>(_size);
+			texture = _arena.alloc<ImTextureID>(_size);
+			srcIdx = _arena.alloc<const ImDrawIdx*>(_size);
+			srcVtx = _arena.alloc<const ImDrawVert*>(_size);
+			callback = _arena.alloc<const ImDrawCmd*>(_size);
+			parent = _arena.alloc<const ImDrawList*>(_size);
+			quad = _arena.alloc<uint8_t>(_size);
+		}
+	};
+
+	//scissor rects and the visibility of all commands in one pass. the rects truncate like the casts
+	//glScissor used to get, the sse2 path does 4 commands per iteration
+	inline void clipCommands(CommandList& _cmds, ImVec2 _offset, ImVec2 _scale, uint _width, uint _height) {
+		const float fbw = static_cast<float>(_width);
+		const float fbh = static_cast<float>(_height);
+		uint i = 0;
+#ifdef TURBOGUI_SSE2
+		const __m128 offX = _mm_set1_ps(_offset.x), offY = _mm_set1_ps(_offset.y);
+		const __m128 scaleX = _mm_set1_ps(_scale.x), scaleY = _mm_set1_ps(_scale.y);
+		const __m128 w = _mm_set1_ps(fbw), h = _mm_set1_ps(fbh), zero = _mm_setzero_ps();
+		for (; i + 4 <= _cmds.size; i += 4) {
+			const __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(_cmds.clipX0 + i), offX), scaleX);
+			const __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(_cmds.clipY0 + i), offY), scaleY);
+			const __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(_cmds.clipX1 + i), offX), scaleX);
+			const __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(_cmds.clipY1 + i), offY), scaleY);
+			const __m128 vis = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(x0, w), _mm_cmplt_ps(y0, h)), _mm_and_ps(_mm_cmpge_ps(x1, zero), _mm_cmpge_ps(y1, zero)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(_cmds.x + i), _mm_cvttps_epi32(x0));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(_cmds.y + i), _mm_cvttps_epi32(_mm_sub_ps(h, y1)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(_cmds.width + i), _mm_cvttps_epi32(_mm_sub_ps(x1, x0)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(_cmds.height + i), _mm_cvttps_epi32(_mm_sub_ps(y1, y0)));
+			const int mask = _mm_movemask_ps(vis);
+			for (uint k = 0; k < 4; ++k)
+				_cmds.visible[i + k] = static_cast<uint8_t>((mask >> k) & 1);
+		}
+#endif
+		for (; i < _cmds.size; ++i) {
+			const float x0 = (_cmds.clipX0[i] - _offset.x) * _scale.x;
+			const float y0 = (_cmds.clipY0[i] - _offset.y) * _scale.y;
+			const float x1 = (_cmds.clipX1[i] - _offset.x) * _scale.x;
+			const float y1 = (_cmds.clipY1[i] - _offset.y) * _scale.y;
+			_cmds.visible[i] = x0 < fbw && y0 < fbh && x1 >= 0.f && y1 >= 0.f;
+			if (!_cmds.visible[i]) continue;
+			_cmds.x[i] = (int)x0;
+			_cmds.y[i] = (int)(fbh - y1);
+			_cmds.width[i] = (int)(x1 - x0);
+			_cmds.height[i] = (int)(y1 - y0);
+		}
+	}
+
+	//shadow of the GL state TurboGUI touches. a setter only reaches GL if the value differs from the shadow,
+	//entries the shadow does not know are always emitted
+	class GLStateCache {
+		enum : uint {
+			Caps = 0, //one bit per cap
+			BlendEquation = 4, BlendFunc, PolygonMode, Viewport, ScissorBox, Program, VertexArray,
+			DrawFramebuffer, IndirectBuffer, StorageBuffer, ActiveTexture, Textures //one bit per unit
+		};
+
+	public:
+		//units 0 and 1 are tracked, as GL_TEXTURE_2D and GL_TEXTURE_2D_ARRAY
+		struct State {
+			bool caps[4];
+			GLenum blendEquation[2];
+			GLenum blendFunc[4];
+			GLenum polygonMode;
+			GLint viewport[4];
+			GLint scissorBox[4];
+			GLuint program, vertexArray, drawFramebuffer, indirectBuffer, storageBuffer;
+			GLenum activeTexture;
+			GLuint textures[2];
+			uint known = 0;
+		};
+
+	private:
+		State cur;
+
+		static uint capIndex(GLenum _cap) {
+			return _cap == GL_BLEND ? 0 : _cap == GL_CULL_FACE ? 1 : _cap == GL_DEPTH_TEST ? 2 : 3;
+		}
+
+		//true if the call can be skipped, otherwise the entry is marked known and the call counted
+		bool same(uint _bit, bool _equal) {
+			if ((cur.known & (1u << _bit)) && _equal) return true;
+			cur.known |= 1u << _bit;
+			++calls;
+			return false;
+		}
+
+	public:
+		//calls that reached GL and texture binds among them
+		uint calls = 0;
+		uint textureBinds = 0;
+
+		void invalidate() { cur.known = 0; }
+
+		//drops a deleted texture from the shadow, its name may come back from glGenTextures
+		void forgetTexture(GLuint _tex) {
+			for (uint i = 0; i < 2; ++i)
+				if (cur.textures[i] == _tex)
+					cur.known &= ~(1u << (Textures + i));
+		}
+
+		void enable(GLenum _cap, bool _on) {
+			const uint i = capIndex(_cap);
+			if (same(Caps + i, cur.caps[i] == _on)) return;
+			cur.caps[i] = _on;
+			if (_on) glEnable(_cap);
+			else glDisable(_cap);
+		}
+
+		void blendEquation(GLenum _rgb, GLenum _alpha) {
+			if (same(BlendEquation, cur.blendEquation[0] == _rgb && cur.blendEquation[1] == _alpha)) return;
+			cur.blendEquation[0] = _rgb;
+			cur.blendEquation[1] = _alpha;
+			glBlendEquationSeparate(_rgb, _alpha);
+		}
+
+		void blendFunc(GLenum _srcRgb, GLenum _dstRgb, GLenum _srcAlpha, GLenum _dstAlpha) {
+			GLenum* f = cur.blendFunc;
+			if (same(BlendFunc, f[0] == _srcRgb && f[1] == _dstRgb && f[2] == _srcAlpha && f[3] == _dstAlpha)) return;
+			f[0] = _srcRgb;
+			f[1] = _dstRgb;
+			f[2] = _srcAlpha;
+			f[3] = _dstAlpha;
+			glBlendFuncSeparate(_srcRgb, _dstRgb, _srcAlpha, _dstAlpha);
+		}
+
+		void polygonMode(GLenum _mode) {
+			if (same(PolygonMode, cur.polygonMode == _mode)) return;
+			cur.polygonMode = _mode;
+			glPolygonMode(GL_FRONT_AND_BACK, _mode);
+		}
+
+		void viewport(GLint _x, GLint _y, GLint _w, GLint _h) {
+			GLint* v = cur.viewport;
+			if (same(Viewport, v[0] == _x && v[1] == _y && v[2] == _w && v[3] == _h)) return;
+			v[0] = _x;
+			v[1] = _y;
+			v[2] = _w;
+			v[3] = _h;
+			glViewport(_x, _y, _w, _h);
+		}
+
+		void scissor(GLint _x, GLint _y, GLint _w, GLint _h) {
+			GLint* s = cur.scissorBox;
+			if (same(ScissorBox, s[0] == _x && s[1] == _y && s[2] == _w && s[3] == _h)) return;
+			s[0] = _x;
+			s[1] = _y;
+			s[2] = _w;
+			s[3] = _h;
+			glScissor(_x, _y, _w, _h);
+		}
+
+		void useProgram(GLuint _program) {
+			if (same(Program, cur.program == _program)) return;
+			cur.program = _program;
+			glUseProgram(_program);
+		}
+
+		void bindVertexArray(GLuint _vao) {
+			if (same(VertexArray, cur.vertexArray == _vao)) return;
+			cur.vertexArray = _vao;
+			glBindVertexArray(_vao);
+		}
+
+		void bindDrawFramebuffer(GLuint _fbo) {
+			if (same(DrawFramebuffer, cur.drawFramebuffer == _fbo)) return;
+			cur.drawFramebuffer = _fbo;
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
+		}
+
+		void bindIndirectBuffer(GLuint _buffer) {
+			if (same(IndirectBuffer, cur.indirectBuffer == _buffer)) return;
+			cur.indirectBuffer = _buffer;
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _buffer);
+		}
+
+		//binding point 0
+		void bindStorageBuffer(GLuint _buffer) {
+			if (same(StorageBuffer, cur.storageBuffer == _buffer)) return;
+			cur.storageBuffer = _buffer;
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _buffer);
+		}
+
+		void activeTexture(GLenum _unit) {
+			if (same(ActiveTexture, cur.activeTexture == _unit)) return;
+			cur.activeTexture = _unit;
+			glActiveTexture(_unit);
+		}
+
+		void bindTexture(uint _unit, GLuint _tex) {
+			if ((cur.known & (1u << (Textures + _unit))) && cur.textures[_unit] == _tex) return;
+			activeTexture(GL_TEXTURE0 + _unit);
+			same(Textures + _unit, false);
+			cur.textures[_unit] = _tex;
+			glBindTexture(_unit == 0 ? GL_TEXTURE_2D : GL_TEXTURE_2D_ARRAY, _tex);
+			++textureBinds;
+		}
+
+		//only queried if the shadow does not know it
+		GLuint drawFramebuffer() {
+			if (!(cur.known & (1u << DrawFramebuffer))) {
+				GLint fbo = 0;
+				glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &fbo);
+				cur.drawFramebuffer = static_cast<GLuint>(fbo);
+				cur.known |= 1u << DrawFramebuffer;
+				++calls;
+			}
+			return cur.drawFramebuffer;
+		}
+
+		//queries everything the cache tracks. the result seeds the shadow and can be handed to restore()
+		State save() {
+			State s;
+			const GLenum caps[4] = { GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST };
+			for (uint i = 0; i < 4; ++i)
+				s.caps[i] = glIsEnabled(caps[i]) == GL_TRUE;
+			GLint v[4];
+			glGetIntegerv(GL_BLEND_EQUATION_RGB, v);
+			glGetIntegerv(GL_BLEND_EQUATION_ALPHA, v + 1);
+			s.blendEquation[0] = v[0];
+			s.blendEquation[1] = v[1];
+			glGetIntegerv(GL_BLEND_SRC_RGB, v);
+			glGetIntegerv(GL_BLEND_DST_RGB, v + 1);
+			glGetIntegerv(GL_BLEND_SRC_ALPHA, v + 2);
+			glGetIntegerv(GL_BLEND_DST_ALPHA, v + 3);
+			for (uint i = 0; i < 4; ++i)
+				s.blendFunc[i] = v[i];
+			glGetIntegerv(GL_POLYGON_MODE, v);
+			s.polygonMode = v[0];
+			glGetIntegerv(GL_VIEWPORT, s.viewport);
+			glGetIntegerv(GL_SCISSOR_BOX, s.scissorBox);
+			glGetIntegerv(GL_CURRENT_PROGRAM, v);
+			s.program = v[0];
+			glGetIntegerv(GL_VERTEX_ARRAY_BINDING, v);
+			s.vertexArray = v[0];
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, v);
+			s.drawFramebuffer = v[0];
+			glGetIntegerv(GL_DRAW_INDIRECT_BUFFER_BINDING, v);
+			s.indirectBuffer = v[0];
+			glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, 0, v);
+			s.storageBuffer = v[0];
+			glGetIntegerv(GL_ACTIVE_TEXTURE, v);
+			s.activeTexture = v[0];
+			glActiveTexture(GL_TEXTURE0);
+			glGetIntegerv(GL_TEXTURE_BINDING_2D, v);
+			s.textures[0] = v[0];
+			glActiveTexture(GL_TEXTURE1);
+			glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, v);
+			s.textures[1] = v[0];
+			glActiveTexture(s.activeTexture);
+			calls += 24;
+			s.known = ~0u;
+			cur = s;
+			return s;
+		}
+
+		void restore(const State& _s) {
+			const GLenum caps[4] = { GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST };
+			for (uint i = 0; i < 4; ++i)
+				enable(caps[i], _s.caps[i]);
+			blendEquation(_s.blendEquation[0], _s.blendEquation[1]);
+			blendFunc(_s.blendFunc[0], _s.blendFunc[1], _s.blendFunc[2], _s.blendFunc[3]);
+			polygonMode(_s.polygonMode);
+			viewport(_s.viewport[0], _s.viewport[1], _s.viewport[2], _s.viewport[3]);
+			scissor(_s.scissorBox[0], _s.scissorBox[1], _s.scissorBox[2], _s.scissorBox[3]);
+			useProgram(_s.program);
+			bindVertexArray(_s.vertexArray);
+			bindDrawFramebuffer(_s.drawFramebuffer);
+			bindIndirectBuffer(_s.indirectBuffer);
+			bindStorageBuffer(_s.storageBuffer);
+			bindTexture(1, _s.textures[1]);
+			bindTexture(0, _s.textures[0]);
+			activeTexture(_s.activeTexture);
+		}
+	};
+
+	//read only view of a whole file. mmap where available, a plain read elsewhere
+	class MappedFile {
+		const unsigned char* ptr = nullptr;
+		size_t length = 0;
+		std::vector<unsigned char> buffer;
+
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile() { close(); }
+
+		bool open(const std::string& _path) {
+			close();
+#ifdef TURBOGUI_MMAP
+			const int fd = ::open(_path.c_str(), O_RDONLY);
+			if (fd < 0) return false;
+			struct stat st;
+			if (fstat(fd, &st) == 0 && st.st_size > 0) {
+				void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p != MAP_FAILED) {
+					ptr = static_cast<const unsigned char*>(p);
+					length = (size_t)st.st_size;
+				}
+			}
+			::close(fd);
+#else
+			std::ifstream in(_path, std::ios::binary);
+			buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			ptr = buffer.data();
+			length = buffer.size();
+#endif
+			return length != 0;
+		}
+
+		void close() {
+#ifdef TURBOGUI_MMAP
+			if (ptr) munmap(const_cast<unsigned char*>(ptr), length);
+#endif
+			buffer = std::vector<unsigned char>();
+			ptr = nullptr;
+			length = 0;
+		}
+
+		const unsigned char* data() const { return ptr; }
+		size_t size() const { return length; }
+	};
+
+	//a file next to _path that no other writer, in this process or another, picks at the same time
+	inline std::string tempPath(const std::string& _path) {
+		const uint64_t id = std::chrono::steady_clock::now().time_since_epoch().count() ^ (std::hash<std::thread::id>()(std::this_thread::get_id()) << 1);
+		char suffix[24];
+		std::snprintf(suffix, sizeof(suffix), ".%016llx", static_cast<unsigned long long>(id));
+		return _path + suffix;
+	}
+
+	//moves _from over _to in one step, a reader sees the old file or the new one but never none or a part
+	inline bool replaceFile(const std::string& _from, const std::string& _to) {
+#ifdef _WIN32
+		if (MoveFileExA(_from.c_str(), _to.c_str(), MOVEFILE_REPLACE_EXISTING)) return true;
+#else
+		if (std::rename(_from.c_str(), _to.c_str()) == 0) return true;
+#endif
+		std::remove(_from.c_str());
+		return false;
+	}
+
+	//font atlas cache. a built atlas is stored as its alpha pixels plus everything ImGui keeps about the glyphs,
+	//keyed by the font configuration. a hit replaces the rasterization in Build() with a copy out of the mapping.
+	//this writes the atlas internals of the imgui version pinned in CMakeLists.txt, the key holds IMGUI_VERSION_NUM
+	namespace FontCache {
+
+		constexpr uint32_t Magic = 0x41464254; //TBFA
+		constexpr uint32_t Version = 2;
+
+		struct Header {
+			uint32_t magic, version;
+			uint64_t key;
+			int32_t width, height;
+			int32_t fonts, glyphs, rects;
+			int32_t packIdMouseCursors, packIdLines;
+			ImVec2 uvScale, uvWhitePixel;
+			//fills the tail up to the alignment of key, no uninitialized padding goes to disk
+			uint32_t reserved;
+		};
+		static_assert(sizeof(Header) == 64, "FontCache::Header has padding");
+		struct FontRecord {
+			float size, ascent, descent;
+			int32_t glyphs;
+			uint32_t fallbackChar, ellipsisChar;
+		};
+		static_assert(sizeof(FontRecord) == 24, "FontCache::FontRecord has padding");
+		//ImFontAtlasCustomRect with the font as index
+		struct RectRecord {
+			uint16_t width, height, x, y;
+			uint32_t glyphID;
+			float glyphAdvanceX;
+			ImVec2 glyphOffset;
+			int32_t font;
+		};
+		static_assert(sizeof(RectRecord) == 28, "FontCache::RectRecord has padding");
+
+		//everything Build() reads: the font files, their configs and the custom rects added so far
+		inline uint64_t key(const ImFontAtlas* _atlas) {
+			uint64_t h = hashBytes(&Version, sizeof(Version), IMGUI_VERSION_NUM);
+			const int atlas[3] = { (int)_atlas->Flags, _atlas->TexDesiredWidth, _atlas->TexGlyphPadding };
+			h = hashBytes(atlas, sizeof(atlas), h);
+			for (const ImFontConfig& c : _atlas->ConfigData) {
+				h = hashBytes(c.FontData, (size_t)c.FontDataSize, h);
+				int font = 0;
+				while (font < _atlas->Fonts.Size && _atlas->Fonts[font] != c.DstFont) ++font;
+				const float f[8] = { c.SizePixels, c.GlyphExtraSpacing.x, c.GlyphExtraSpacing.y, c.GlyphOffset.x, c.GlyphOffset.y,
+					c.GlyphMinAdvanceX, c.GlyphMaxAdvanceX, c.RasterizerMultiply };
+				const int i[8] = { c.FontNo, c.OversampleH, c.OversampleV, c.PixelSnapH, c.MergeMode, (int)c.FontBuilderFlags, (int)c.EllipsisChar, font };
+				h = hashBytes(f, sizeof(f), h);
+				h = hashBytes(i, sizeof(i), h);
+				const ImWchar* r = c.GlyphRanges;
+				size_t n = 0;
+				while (r && r[n] != 0) n += 2;
+				h = hashBytes(r, n * sizeof(ImWchar), h);
+			}
+			for (const ImFontAtlasCustomRect& r : _atlas->CustomRects) {
+				int font = -1;
+				for (int i = 0; i < _atlas->Fonts.Size; ++i)
+					if (_atlas->Fonts[i] == r.Font) font = i;
+				const float f[3] = { r.GlyphAdvanceX, r.GlyphOffset.x, r.GlyphOffset.y };
+				const int i[4] = { r.Width, r.Height, (int)r.GlyphID, font };
+				h = hashBytes(f, sizeof(f), h);
+				h = hashBytes(i, sizeof(i), h);
+			}
+			return h;
+		}
+
+		//restores the atlas from _file if it holds _key. the returned pixels are the TexPixelsAlpha8 of the atlas
+		inline const unsigned char* load(ImFontAtlas* _atlas, const MappedFile& _file, uint64_t _key) {
+			const unsigned char* p = _file.data();
+			const unsigned char* end = p + _file.size();
+			Header h{};
+			if (_file.size() < sizeof(Header)) return nullptr;
+			std::memcpy(&h, p, sizeof(Header));
+			if (h.magic != Magic || h.version != Version || h.key != _key || h.fonts != _atlas->Fonts.Size)
+				return nullptr;
+			const size_t need = sizeof(Header) + sizeof(_atlas->TexUvLines) + h.fonts * sizeof(FontRecord) + h.glyphs * sizeof(ImFontGlyph)
+				+ h.rects * sizeof(RectRecord) + (size_t)h.width * h.height;
+			if (h.width <= 0 || h.height <= 0 || h.glyphs < 0 || h.rects < 0 || (size_t)(end - p) != need)
+				return nullptr;
+			p += sizeof(Header);
+
+			std::vector<FontRecord> fonts(h.fonts);
+			std::memcpy(_atlas->TexUvLines, p, sizeof(_atlas->TexUvLines));
+			p += sizeof(_atlas->TexUvLines);
+			std::memcpy(fonts.data(), p, fonts.size() * sizeof(FontRecord));
+			p += fonts.size() * sizeof(FontRecord);
+			//every count has to fit what is left of the glyphs, so no sum of them can wrap around
+			int glyphs = h.glyphs;
+			for (const FontRecord& f : fonts) {
+				if (f.glyphs < 0 || f.glyphs > glyphs) return nullptr;
+				glyphs -= f.glyphs;
+			}
+			if (glyphs != 0) return nullptr;
+
+			for (int i = 0; i < h.fonts; ++i) {
+				ImFont* font = _atlas->Fonts[i];
+				const FontRecord& f = fonts[i];
+				font->FontSize = f.size;
+				font->Ascent = f.ascent;
+				font->Descent = f.descent;
+				font->FallbackChar = (ImWchar)f.fallbackChar;
+				font->EllipsisChar = (ImWchar)f.ellipsisChar;
+				font->ContainerAtlas = _atlas;
+				font->ConfigData = nullptr;
+				font->ConfigDataCount = 0;
+				font->Glyphs.resize(f.glyphs);
+				std::memcpy(font->Glyphs.Data, p, f.glyphs * sizeof(ImFontGlyph));
+				p += f.glyphs * sizeof(ImFontGlyph);
+			}
+			for (ImFontConfig& c : _atlas->ConfigData) {
+				if (!c.DstFont) continue;
+				if (!c.DstFont->ConfigData)
+					c.DstFont->ConfigData = &c;
+				++c.DstFont->ConfigDataCount;
+			}
+
+			_atlas->CustomRects.resize(h.rects);
+			for (ImFontAtlasCustomRect& r : _atlas->CustomRects) {
+				RectRecord rr;
+				std::memcpy(&rr, p, sizeof(RectRecord));
+				p += sizeof(RectRecord);
+				r.Width = rr.width;
+				r.Height = rr.height;
+				r.X = rr.x;
+				r.Y = rr.y;
+				r.GlyphID = rr.glyphID;
+				r.GlyphAdvanceX = rr.glyphAdvanceX;
+				r.GlyphOffset = rr.glyphOffset;
+				r.Font = rr.font < 0 || rr.font >= h.fonts ? nullptr : _atlas->Fonts[rr.font];
+			}
+
+			_atlas->TexWidth = h.width;
+			_atlas->TexHeight = h.height;
+			_atlas->TexUvScale = h.uvScale;
+			_atlas->TexUvWhitePixel = h.uvWhitePixel;
+			_atlas->PackIdMouseCursors = h.packIdMouseCursors;
+			_atlas->PackIdLines = h.packIdLines;
+			for (ImFont* font : _atlas->Fonts)
+				font->BuildLookupTable();
+			//the atlas owns and frees its pixels. with them set it counts as built, NewFrame() asserts that and
+			//GetTexDataAs*() would rasterize again otherwise
+			IM_FREE(_atlas->TexPixelsAlpha8);
+			_atlas->TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC((size_t)h.width * h.height));
+			std::memcpy(_atlas->TexPixelsAlpha8, p, (size_t)h.width * h.height);
+			return _atlas->TexPixelsAlpha8;
+		}
+
+		//written next to the target and renamed, a concurrent start never maps a half written file
+		inline void save(const ImFontAtlas* _atlas, const unsigned char* _alpha, const std::string& _path, uint64_t _key) {
+			Header h = { Magic, Version, _key, _atlas->TexWidth, _atlas->TexHeight, _atlas->Fonts.Size, 0, _atlas->CustomRects.Size,
+				_atlas->PackIdMouseCursors, _atlas->PackIdLines, _atlas->TexUvScale, _atlas->TexUvWhitePixel, 0 };
+			std::vector<FontRecord> fonts;
+			for (const ImFont* f : _atlas->Fonts) {
+				fonts.push_back({ f->FontSize, f->Ascent, f->Descent, f->Glyphs.Size, (uint32_t)f->FallbackChar, (uint32_t)f->EllipsisChar });
+				h.glyphs += f->Glyphs.Size;
+			}
+
+			const std::string tmp = tempPath(_path);
+			{
+				std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+				out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+				out.write(reinterpret_cast<const char*>(_atlas->TexUvLines), sizeof(_atlas->TexUvLines));
+				out.write(reinterpret_cast<const char*>(fonts.data()), fonts.size() * sizeof(FontRecord));
+				for (const ImFont* f : _atlas->Fonts)
+					out.write(reinterpret_cast<const char*>(f->Glyphs.Data), f->Glyphs.Size * sizeof(ImFontGlyph));
+				for (const ImFontAtlasCustomRect& r : _atlas->CustomRects) {
+					int32_t font = -1;
+					for (int i = 0; i < _atlas->Fonts.Size; ++i)
+						if (_atlas->Fonts[i] == r.Font) font = i;
+					const RectRecord rr = { r.Width, r.Height, r.X, r.Y, r.GlyphID, r.GlyphAdvanceX, r.GlyphOffset, font };
+					out.write(reinterpret_cast<const char*>(&rr), sizeof(rr));
+				}
+				out.write(reinterpret_cast<const char*>(_alpha), (std::streamsize)_atlas->TexWidth * _atlas->TexHeight);
+				if (!out) {
+					out.close();
+					std::remove(tmp.c_str());
+					return;
+				}
+			}
+			replaceFile(tmp, _path);
+		}
+
+	}
+
+	//binary capture of ImDrawData, replayed without ImGui. the file is a header followed by one record per frame,
+	//a frame holds per list its commands, then its vertices and indices as ImGui wrote them. every array starts
+	//4 byte aligned, so a replay points the lists straight into the mapping
+	namespace DrawCapture {
+
+		constexpr uint32_t Magic = 0x43444254; //TBDC
+		constexpr uint32_t Version = 1;
+
+		//sizes of ImDrawVert and ImDrawIdx, a replay needs the same imconfig.h
+		struct Header {
+			uint32_t magic, version;
+			uint32_t vertSize, idxSize;
+		};
+		//bytes covers the whole frame including this record, a replay skips a frame without parsing it
+		struct FrameRecord {
+			uint32_t bytes, lists;
+			ImVec2 displayPos, displaySize, framebufferScale;
+		};
+		//id numbers the lists of a capture in the order they first showed up. it stays the same while the list
+		//lives in the captured process, so list cache and damage tracking see the lists they saw during the capture
+		struct ListRecord {
+			uint64_t id;
+			uint32_t cmds, vtx, idx, flags;
+		};
+		static_assert(sizeof(FrameRecord) == 32 && sizeof(ListRecord) == 24, "DrawCapture records have padding");
+		enum : uint32_t {
+			NoCallback,
+			//ImDrawCallback_ResetRenderState
+			ResetCallback,
+			//any other callback. function and data do not survive the process, the replay drops the command
+			UserCallback
+		};
+		//the texture of the font is written as 0, which the GUI of the replay resolves to its own font
+		struct CmdRecord {
+			ImVec4 clipRect;
+			uint64_t texture;
+			uint32_t vtxOffset, idxOffset, elemCount, callback;
+		};
+		static_assert(sizeof(CmdRecord) == 40, "DrawCapture::CmdRecord has padding");
+
+		//64 bit, counts read from a file cannot overflow it
+		inline uint64_t padded(uint64_t _bytes) { return (_bytes + 3u) & ~uint64_t(3); }
+
+	}
+
+	//writes every frame handed to record() to a capture file
+	class DrawRecorder {
+		std::ofstream out;
+		uint frames = 0;
+		bool failed = false;
+		std::vector<DrawCapture::CmdRecord> cmds;
+		//ids of the lists seen so far, by their key
+		std::unordered_map<const ImDrawList*, uint64_t> ids;
+
+	public:
+		bool open(const std::string& _path) {
+			out = std::ofstream(_path, std::ios::binary | std::ios::trunc);
+			frames = 0;
+			failed = false;
+			ids.clear();
+			const DrawCapture::Header h = { DrawCapture::Magic, DrawCapture::Version, (uint32_t)sizeof(ImDrawVert), (uint32_t)sizeof(ImDrawIdx) };
+			out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+			return (bool)out;
+		}
+
+		//_keys identify the lists across frames, see DrawCapture::ListRecord. _font is the texture of the atlas.
+		//a frame the format cannot hold or a failed write ends the capture and returns false, the frames before
+		//it stay in the file
+		bool record(const ImDrawData* _data, const ImDrawList* const* _keys, ImTextureID _font) {
+			using namespace DrawCapture;
+			uint64_t bytes = sizeof(FrameRecord);
+			for (int n = 0; n < _data->CmdListsCount; ++n) {
+				const ImDrawList* l = _data->CmdLists[n];
+				bytes += sizeof(ListRecord) + (uint64_t)l->CmdBuffer.Size * sizeof(CmdRecord) + padded(l->VtxBuffer.size_in_bytes())
+					+ padded(l->IdxBuffer.size_in_bytes());
+			}
+			if (bytes > UINT32_MAX) return fail();
+			const FrameRecord f = { (uint32_t)bytes, (uint32_t)_data->CmdListsCount, _data->DisplayPos, _data->DisplaySize, _data->FramebufferScale };
+			out.write(reinterpret_cast<const char*>(&f), sizeof(f));
+			const uint32_t zero = 0;
+			for (int n = 0; n < _data->CmdListsCount; ++n) {
+				const ImDrawList* l = _data->CmdLists[n];
+				//a lookup first, emplace builds a node even if the key is there
+				auto it = ids.find(_keys[n]);
+				if (it == ids.end())
+					it = ids.emplace(_keys[n], ids.size()).first;
+				const uint64_t id = it->second;
+				const ListRecord r = { id, (uint32_t)l->CmdBuffer.Size, (uint32_t)l->VtxBuffer.Size, (uint32_t)l->IdxBuffer.Size, (uint32_t)l->Flags };
+				out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+				cmds.resize(l->CmdBuffer.Size);
+				for (int c = 0; c < l->CmdBuffer.Size; ++c) {
+					const ImDrawCmd& cmd = l->CmdBuffer[c];
+					const uint32_t callback = !cmd.UserCallback ? NoCallback : cmd.UserCallback == ImDrawCallback_ResetRenderState ? ResetCallback : UserCallback;
+					cmds[c] = { cmd.ClipRect, cmd.TextureId == _font ? 0 : (uint64_t)(uintptr_t)cmd.TextureId, cmd.VtxOffset, cmd.IdxOffset, cmd.ElemCount, callback };
+				}
+				out.write(reinterpret_cast<const char*>(cmds.data()), cmds.size() * sizeof(CmdRecord));
+				out.write(reinterpret_cast<const char*>(l->VtxBuffer.Data), l->VtxBuffer.size_in_bytes());
+				out.write(reinterpret_cast<const char*>(&zero), (std::streamsize)(padded(l->VtxBuffer.size_in_bytes()) - l->VtxBuffer.size_in_bytes()));
+				out.write(reinterpret_cast<const char*>(l->IdxBuffer.Data), l->IdxBuffer.size_in_bytes());
+				out.write(reinterpret_cast<const char*>(&zero), (std::streamsize)(padded(l->IdxBuffer.size_in_bytes()) - l->IdxBuffer.size_in_bytes()));
+			}
+			//a write that fails sets the stream, the buffered tail is checked by close()
+			if (!out) return fail();
+			++frames;
+			return true;
+		}
+
+		void close() {
+			if (!out.is_open()) return;
+			out.close();
+			failed = failed || !out;
+		}
+		bool isOpen() const { return out.is_open(); }
+		uint getFrames() const { return frames; }
+		bool isFailed() const { return failed; }
+
+	private:
+		bool fail() {
+			failed = true;
+			out.close();
+			return false;
+		}
+	};
+
+	//maps a capture file and turns its frames back into ImDrawData. vertices and indices are not copied, the
+	//lists point into the mapping. a frame stays valid until the next call to frame()
+	class DrawReplay {
+		MappedFile file;
+		std::vector<size_t> offsets;
+		//one list per captured id, reused by every frame it shows up in
+		std::unordered_map<uint64_t, ImDrawList*> lists;
+		std::vector<ImDrawList*> frameLists;
+		ImDrawData data;
+
+		//the buffers belong to the mapping
+		static void detach(ImDrawList* _list) {
+			_list->VtxBuffer.Data = nullptr;
+			_list->VtxBuffer.Size = _list->VtxBuffer.Capacity = 0;
+			_list->IdxBuffer.Data = nullptr;
+			_list->IdxBuffer.Size = _list->IdxBuffer.Capacity = 0;
+		}
+
+		//the commands of a list whose record fits the frame stay inside its buffers, their indices inside its vertices
+		static bool validList(const DrawCapture::ListRecord& _r, const unsigned char* _cmds) {
+			using namespace DrawCapture;
+			if (_r.vtx > (uint32_t)INT_MAX || _r.idx > (uint32_t)INT_MAX || _r.cmds > (uint32_t)INT_MAX) return false;
+			const unsigned char* idx = _cmds + (uint64_t)_r.cmds * sizeof(CmdRecord) + padded((uint64_t)_r.vtx * sizeof(ImDrawVert));
+			for (uint c = 0; c < _r.cmds; ++c) {
+				CmdRecord cr;
+				std::memcpy(&cr, _cmds + (uint64_t)c * sizeof(CmdRecord), sizeof(CmdRecord));
+				if (cr.callback == UserCallback) continue;
+				if ((uint64_t)cr.idxOffset + cr.elemCount > _r.idx || (cr.elemCount != 0 && cr.vtxOffset >= _r.vtx)) return false;
+				for (uint k = 0; k < cr.elemCount; ++k) {
+					ImDrawIdx i;
+					std::memcpy(&i, idx + ((uint64_t)cr.idxOffset + k) * sizeof(ImDrawIdx), sizeof(ImDrawIdx));
+					if ((uint64_t)cr.vtxOffset + i >= _r.vtx) return false;
+				}
+			}
+			return true;
+		}
+
+	public:
+		DrawReplay() = default;
+		DrawReplay(const DrawReplay&) = delete;
+		DrawReplay& operator=(const DrawReplay&) = delete;
+		~DrawReplay() { close(); }
+
+		//false if the file is missing or was captured with another ImDrawVert/ImDrawIdx. a truncated last frame
+		//is left out, so is every frame from the first one that does not hold together
+		bool open(const std::string& _path) {
+			using namespace DrawCapture;
+			close();
+			if (!file.open(_path) || file.size() < sizeof(Header)) return false;
+			Header h;
+			std::memcpy(&h, file.data(), sizeof(Header));
+			if (h.magic != Magic || h.version != Version || h.vertSize != sizeof(ImDrawVert) || h.idxSize != sizeof(ImDrawIdx)) {
+				file.close();
+				return false;
+			}
+			size_t p = sizeof(Header);
+			while (file.size() - p >= sizeof(FrameRecord)) {
+				FrameRecord f;
+				std::memcpy(&f, file.data() + p, sizeof(FrameRecord));
+				if (f.bytes < sizeof(FrameRecord) || f.bytes > file.size() - p) break;
+				//the lists have to add up to the frame and every command has to stay inside its list, frame() and
+				//the gui trust them
+				const unsigned char* frame = file.data() + p;
+				uint64_t bytes = sizeof(FrameRecord);
+				uint n = 0;
+				for (; n < f.lists && bytes + sizeof(ListRecord) <= f.bytes; ++n) {
+					ListRecord r;
+					std::memcpy(&r, frame + bytes, sizeof(ListRecord));
+					const uint64_t cmdBytes = (uint64_t)r.cmds * sizeof(CmdRecord);
+					const uint64_t vtxBytes = padded((uint64_t)r.vtx * sizeof(ImDrawVert));
+					const uint64_t idxBytes = padded((uint64_t)r.idx * sizeof(ImDrawIdx));
+					if (sizeof(ListRecord) + cmdBytes + vtxBytes + idxBytes > f.bytes - bytes || !validList(r, frame + bytes + sizeof(ListRecord)))
+						break;
+					bytes += sizeof(ListRecord) + cmdBytes + vtxBytes + idxBytes;
+				}
+				if (n != f.lists || bytes != f.bytes) break;
+				offsets.push_back(p);
+				p += f.bytes;
+			}
+			return true;
+		}
+
+		void close() {
+			for (auto& l : lists) {
+				detach(l.second);
+				IM_DELETE(l.second);
+			}
+			lists.clear();
+			offsets.clear();
+			file.close();
+		}
+
+		uint getFrames() const { return static_cast<uint>(offsets.size()); }
+
+		ImDrawData* frame(uint _frame) {
+			using namespace DrawCapture;
+			const unsigned char* p = file.data() + offsets[_frame];
+			FrameRecord f;
+			std::memcpy(&f, p, sizeof(FrameRecord));
+			p += sizeof(FrameRecord);
+			frameLists.resize(f.lists);
+			data = ImDrawData();
+			data.Valid = true;
+			for (uint n = 0; n < f.lists; ++n) {
+				ListRecord r;
+				std::memcpy(&r, p, sizeof(ListRecord));
+				p += sizeof(ListRecord);
+				ImDrawList*& l = lists[r.id];
+				if (!l)
+					l = IM_NEW(ImDrawList)(nullptr);
+				l->Flags = (ImDrawListFlags)r.flags;
+				l->CmdBuffer.resize(r.cmds);
+				for (uint c = 0; c < r.cmds; ++c, p += sizeof(CmdRecord)) {
+					CmdRecord cr;
+					std::memcpy(&cr, p, sizeof(CmdRecord));
+					ImDrawCmd& cmd = l->CmdBuffer[c];
+					cmd = ImDrawCmd();
+					cmd.ClipRect = cr.clipRect;
+					cmd.TextureId = (ImTextureID)(uintptr_t)cr.texture;
+					cmd.VtxOffset = cr.vtxOffset;
+					cmd.IdxOffset = cr.idxOffset;
+					cmd.ElemCount = cr.callback == UserCallback ? 0 : cr.elemCount;
+					cmd.UserCallback = cr.callback == ResetCallback ? ImDrawCallback_ResetRenderState : nullptr;
+				}
+				//the gui only reads them
+				l->VtxBuffer.Data = reinterpret_cast<ImDrawVert*>(const_cast<unsigned char*>(p));
+				l->VtxBuffer.Size = l->VtxBuffer.Capacity = (int)r.vtx;
+				p += padded((uint64_t)r.vtx * sizeof(ImDrawVert));
+				l->IdxBuffer.Data = reinterpret_cast<ImDrawIdx*>(const_cast<unsigned char*>(p));
+				l->IdxBuffer.Size = l->IdxBuffer.Capacity = (int)r.idx;
+				p += padded((uint64_t)r.idx * sizeof(ImDrawIdx));
+				frameLists[n] = l;
+				data.TotalVtxCount += (int)r.vtx;
+				data.TotalIdxCount += (int)r.idx;
+			}
+			data.CmdLists = frameLists.data();
+			data.CmdListsCount = (int)f.lists;
+			data.DisplayPos = f.displayPos;
+			data.DisplaySize = f.displaySize;
+			data.FramebufferScale = f.framebufferScale;
+			return &data;
+		}
+	};
+
+	//_retrievable allows glGetProgramBinary on the result. without a fragment shader the first source is a
+	//compute shader
+	GLuint compileProgram(const GLchar*, const GLchar*, bool _retrievable = false);
+	//pixels of a font texture, alpha only unless the atlas holds colored glyphs
+	struct FontPixels {
+		const unsigned char* data;
+		int width, height;
+		bool rgba;
+		//restored from the font cache instead of rasterized
+		bool cached;
+	};
+
+	//builds the atlas, or restores it from the font cache in _dir if that holds its configuration. _file holds
+	//the mapping while the atlas is restored
+	inline FontPixels buildFont(ImFontAtlas* _atlas, const std::string& _dir, MappedFile& _file) {
+		std::string path;
+		uint64_t key = 0;
+		if (!_dir.empty() && !_atlas->IsBuilt()) {
+			//Build() would add it too, the key has to see it
+			if (_atlas->Fonts.Size == 0)
+				_atlas->AddFontDefault();
+			key = FontCache::key(_atlas);
+			char name[32];
+			std::snprintf(name, sizeof(name), "/tbfont_%016llx.bin", static_cast<unsigned long long>(key));
+			path = _dir + name;
+			if (_file.open(path))
+				if (const unsigned char* pixels = FontCache::load(_atlas, _file, key))
+					return { pixels, _atlas->TexWidth, _atlas->TexHeight, false, true };
+		}
+
+		unsigned char* pixels;
+		int width, height;
+		_atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+		if (_atlas->TexPixelsUseColors) {
+			_atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+			return { pixels, width, height, true, false };
+		}
+		if (!path.empty())
+			FontCache::save(_atlas, pixels, path, key);
+		return { pixels, width, height, false, false };
+	}
+
+	//r8 with a swizzle to (1, 1, 1, r), the shaders sample the same colors as from the rgba atlas
+	GLuint createFontTexture(const FontPixels&);
+
+	//the programs of the draw modes and the retained frame. uniforms that never change are set once here
+	struct Programs {
+		GLuint shader = 0, indirect = 0, drawId = 0, composite = 0;
+		//the draw programs pulling quads instead of reading ImDrawVerts, created with the first frame that uses them
+		GLuint quadShader = 0, quadIndirect = 0, quadDrawId = 0;
+		//drawing and decimating plots, created with the first plot
+		GLuint plot = 0, decimate = 0;
+		bool bindless = false;
+		//directory of the program binary cache, empty if disabled. cacheHits counts the programs loaded from it
+		std::string cache;
+		uint cacheHits = 0;
+
+		void create();
+		void createQuads();
+		void createDrawPrograms(bool, GLuint&, GLuint&, GLuint&);
+		void createPlot();
+		void destroy();
+		//links from the cache if it holds a binary the driver accepts, compiles and stores one otherwise
+		GLuint build(const GLchar*, const GLchar*);
+	};
+
+	//frame pacing from the fence history. the gpu latency of a frame, from the fence in sync() until it signals,
+	//is averaged over the waits that returned at the signal. a fence a poll finds signaled only bounds it from
+	//above. from that the pacer predicts when a frame in flight completes and how to wait for it
+	class FramePacer {
+	public:
+		typedef std::chrono::steady_clock Clock;
+		enum class Wait {
+			//spin on the fence, the frame is due in less than PollTime
+			Poll,
+			//sleep until SleepMargin before the prediction, then block
+			Sleep,
+			Block
+		};
+		static constexpr float PollTime = 0.2f; //ms
+		static constexpr float SleepTime = 2.f; //ms
+		//sleep_until overshoots by up to a scheduler tick
+		static constexpr float SleepMargin = 1.f; //ms
+
+	private:
+		//at least as many frames as can be in flight, see GUI::MaxRegions
+		static constexpr uint History = 16;
+		static constexpr float Alpha = 0.25f;
+		struct Frame {
+			uint serial = ~0u;
+			Clock::time_point begin, submit;
+		};
+		Frame frames[History];
+		//ewma of the gpu latency and of begin() until sync(), ms
+		float gpu = 0.f, cpu = 0.f;
+		bool seeded = false;
+		PacingStats stats;
+		//when the last frame left sync() under a frame rate target
+		Clock::time_point last;
+
+	public:
+		static float ms(Clock::duration _d) { return std::chrono::duration<float, std::milli>(_d).count(); }
+		static Clock::duration duration(float _ms) { return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(_ms)); }
+
+		//the input of frame _serial is sampled
+		void begin(uint _serial, Clock::time_point _t) {
+			Frame& f = frames[_serial % History];
+			f.serial = _serial;
+			f.begin = _t;
+		}
+		//sync() of frame _serial starts, the cpu work is done
+		void ready(uint _serial, Clock::time_point _t) {
+			Frame& f = frames[_serial % History];
+			if (f.serial != _serial) {
+				f.serial = _serial;
+				f.begin = _t;
+			}
+			cpu += (ms(_t - f.begin) - cpu) * Alpha;
+			stats.cpu = cpu;
+		}
+		//the fence of frame _serial is set
+		void submit(uint _serial, Clock::time_point _t) {
+			frames[_serial % History].submit = _t;
+		}
+		//the fence of frame _serial was seen signaled at _t. _waited if a wait returned because it signaled
+		void complete(uint _serial, Clock::time_point _t, bool _waited) {
+			const Frame& f = frames[_serial % History];
+			if (f.serial != _serial) return;
+			const float sample = ms(_t - f.submit);
+			if (!seeded || _waited)
+				gpu = seeded ? gpu + (sample - gpu) * Alpha : sample;
+			else
+				gpu = std::min(gpu, sample);
+			seeded = true;
+			stats.gpu = gpu;
+			stats.latency = ms((_waited ? _t : std::min(_t, f.submit + duration(gpu))) - f.begin);
+		}
+
+		Clock::time_point predict(uint _serial) const {
+			return frames[_serial % History].submit + duration(gpu);
+		}
+		Wait strategy(uint _serial, Clock::time_point _now) const {
+			const float left = ms(predict(_serial) - _now);
+			return left < PollTime ? Wait::Poll : left > SleepTime ? Wait::Sleep : Wait::Block;
+		}
+		void count(Wait _wait) {
+			++(_wait == Wait::Poll ? stats.polls : _wait == Wait::Sleep ? stats.sleeps : stats.blocks);
+		}
+
+		//when the next frame has to start to be done by _due
+		Clock::time_point start(Clock::time_point _due) const {
+			return _due - duration(cpu + SleepMargin);
+		}
+		//the next frame under a frame rate target of _period ms. a frame more than a period late restarts the
+		//schedule instead of rushing the following ones
+		Clock::time_point next(float _period) const {
+			return last + duration(_period);
+		}
+		//holds the frame back until next(_period). without _wait the frame was already delayed before begin()
+		void limit(float _period, bool _wait) {
+			const Clock::time_point due = next(_period);
+			Clock::time_point now = Clock::now();
+			if (_wait) {
+				if (due > now + duration(SleepMargin))
+					std::this_thread::sleep_until(due - duration(SleepMargin));
+				while ((now = Clock::now()) < due)
+					std::this_thread::yield();
+			}
+			last = now - due > duration(_period) ? now : std::max(now, due);
+		}
+
+		const PacingStats& getStats() const { return stats; }
+	};
+
+	//where gl puts the window origin. Query reads GL_CLIP_ORIGIN in initGL()
+	enum class ClipOrigin {
+		Query,
+		LowerLeft,
+		UpperLeft
+	};
+
+	//compile time policies of a GUI. derive from it and shadow what differs:
+	//    struct MyConfig : TurboGUI::DefaultConfig { static constexpr bool Stats = false; };
+	//    TurboGUI::GUI<MyConfig> gui;
+	struct DefaultConfig {
+		//frames the gpu may lag behind [2, 4], 0 takes the argument of initGL()
+		static constexpr uint FramesInFlight = 0;
+		//initial vertex format. with FixedFormat it is the only one and setVertexFormat() does not compile
+		static constexpr VertexFormat Format = VertexFormat::Float;
+		static constexpr bool FixedFormat = false;
+		//initial draw mode. with FixedDrawMode it is the only one and setDrawMode() does not compile
+		static constexpr DrawMode Mode = DrawMode::Direct;
+		static constexpr bool FixedDrawMode = false;
+		//initial map mode. with FixedMapMode it is the only one and setMapMode() does not compile
+		static constexpr MapMode Map = MapMode::Persistent;
+		static constexpr bool FixedMapMode = false;
+		//features draw() is compiled with. without one its setters do not compile and draw() never branches on it
+		static constexpr bool Retained = true; //setRetainedFrame(), setDamageTracking()
+		static constexpr bool QuadPulling = true; //setQuadPulling()
+		static constexpr bool ListCache = true; //setListCache()
+		static constexpr bool UploadThreads = true; //setUploadThreads()
+		//cpu timings, metric histograms, gpu timer queries and the trace. the counters (upload bytes, draw
+		//calls, ...) are kept either way
+		static constexpr bool Stats = true;
+		static constexpr ClipOrigin Origin = ClipOrigin::Query;
+	};
+
+	//for shipping builds: no instrumentation, float vertices drawn directly from a persistent mapping, two frames
+	//in flight, gl's lower left origin and none of the optional features
+	struct MinimalConfig : DefaultConfig {
+		static constexpr uint FramesInFlight = 2;
+		static constexpr bool FixedFormat = true;
+		static constexpr bool FixedDrawMode = true;
+		static constexpr bool FixedMapMode = true;
+		static constexpr bool Stats = false;
+		static constexpr ClipOrigin Origin = ClipOrigin::LowerLeft;
+		static constexpr bool Retained = false;
+		static constexpr bool QuadPulling = false;
+		static constexpr bool ListCache = false;
+		static constexpr bool UploadThreads = false;
+	};
+
+	template<class Config = DefaultConfig>
+	class GUI;
+
+	//gl resources several GUI instances can draw with: one set of programs, the font textures deduplicated
+	//by their pixels and one streaming arena the vertex and index storage of every GUI is cut from. each GUI
+	//keeps its own ring, fences and indirect records inside its slice. create it with the gl context current
+	//and destroy it after the last GUI that uses it
+	class Renderer {
+		template<class> friend class GUI;
+
+		struct Font {
+			GLuint tex;
+			uint refs;
+		};
+		//slices given back by a GUI, reusable once the gpu passed their fence
+		struct RetiredSlice {
+			uint vtx, vtxCount, idx, idxCount;
+			GLsync fence;
+		};
+
+		Programs programs;
+		float initTime = 0.f; //ms
+		std::unordered_map<uint64_t, Font> fonts;
+		std::string fontCache;
+
+		VertexFormat vertexFormat;
+		uint vertSize;
+		MapMode mapMode;
+		GLuint VBO = 0, EBO = 0;
+		unsigned char* VBO_ptr = nullptr;
+		ImDrawIdx* EBO_ptr = nullptr;
+		uint vtxCapacity, idxCapacity;
+		ArenaAllocator vtxSlices, idxSlices;
+		std::vector<RetiredSlice> retired;
+		uint guis = 0, slices = 0;
+
+		GLuint acquireFont(ImFontAtlas*, bool&);
+		void releaseFont(GLuint);
+		bool allocate(uint, uint, uint&, uint&);
+		//fenced, the gpu may still read the slice
+		void release(uint, uint, uint, uint);
+		void collect();
+
+	public:
+		//_vert and _idx are the size of the arena shared by all GUIs. the GUIs take format and map mode from here.
+		//_programCache is the directory of the program binary cache, see GUI::setProgramCache()
+		Renderer(uint _vert, uint _idx, VertexFormat _format = VertexFormat::Float, MapMode _mode = MapMode::Persistent, const std::string& _programCache = "");
+		~Renderer();
+		Renderer(const Renderer&) = delete;
+		Renderer& operator=(const Renderer&) = delete;
+
+		VertexFormat getVertexFormat() { return vertexFormat; }
+		MapMode getMapMode() { return mapMode; }
+		//GUIs attached with initGL(Renderer&, ...)
+		uint getGUICount() { return guis; }
+		//distinct font textures, GUIs with identical atlases share one
+		uint getFontCount() { return static_cast<uint>(fonts.size()); }
+		//storages cut from the arena, a GUI that did not fit uses buffers of its own
+		uint getSliceCount() { return slices; }
+		//directory of the font cache used by the GUIs attached after this call, see GUI::setFontCache()
+		void setFontCache(const std::string& _dir) {
+			fontCache = _dir;
+		}
+		//time the constructor took, programs included. ms
+		float getInitTime() { return initTime; }
+		uint getProgramCacheHits() { return programs.cacheHits; }
+	};
+
+	template<class Config>
+	class GUI {
+
+		static constexpr uint MaxFramesInFlight = 4;
+		static constexpr uint MaxRegions = 16;
+		static constexpr uint MaxDamageRects = 8;
+		//ImTextureIDs with this bit set name a layer of the image array, everything else is a GL texture name
+		static constexpr uintptr_t ImageFlag = uintptr_t(1) << 31;
+		//the index width is ImDrawIdx, which ImGui takes from imconfig.h
+		static constexpr GLenum IdxType = sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+		static_assert(Config::FramesInFlight == 0 || (Config::FramesInFlight >= 2 && Config::FramesInFlight <= MaxFramesInFlight), "Config::FramesInFlight must be 0 or in [2, 4]");
+
+		//the clock is only read if the config keeps stats
+		static std::chrono::high_resolution_clock::time_point clock() {
+			if constexpr (Config::Stats)
+				return std::chrono::high_resolution_clock::now();
+			else
+				return {};
+		}
+		bool packed() const {
+			if constexpr (Config::FixedFormat)
+				return Config::Format == VertexFormat::Packed;
+			else
+				return vertexFormat == VertexFormat::Packed;
+		}
+		bool lowerLeft() const {
+			if constexpr (Config::Origin == ClipOrigin::Query)
+				return clipOriginLowerLeft;
+			else
+				return Config::Origin == ClipOrigin::LowerLeft;
+		}
+		//the features draw() branches on, constants if the config fixes or drops them
+		DrawMode activeDrawMode() const {
+			if constexpr (Config::FixedDrawMode)
+				return Config::Mode;
+			else
+				return drawMode;
+		}
+		bool explicitFlush() const {
+			if constexpr (Config::FixedMapMode)
+				return Config::Map == MapMode::ExplicitFlush;
+			else
+				return mapMode == MapMode::ExplicitFlush;
+		}
+		bool retaining() const {
+			if constexpr (Config::Retained)
+				return retainFrame;
+			else
+				return false;
+		}
+		bool tracking() const {
+			if constexpr (Config::Retained)
+				return retainFrame && damageTracking;
+			else
+				return false;
+		}
+		bool pullingQuads() const {
+			if constexpr (Config::QuadPulling)
+				return quadPulling;
+			else
+				return false;
+		}
+		bool listCaching() const {
+			if constexpr (Config::ListCache)
+				return arenaVert != 0 && arenaIdx != 0;
+			else
+				return false;
+		}
+		WorkerPool* workers() const {
+			if constexpr (Config::UploadThreads)
+				return uploadPool.get();
+			else
+				return nullptr;
+		}
+
+		//a contiguous slice of both rings written by one submit, guarded by a fence. a frame that does not
+		//fit into the per-frame bound is split into several submits, the last one is closed in sync()
+		struct FrameRegion {
+			GLsync fence = nullptr;
+			uint storage = 0;
+			bool frameEnd = false;
+			uint vtxBegin = 0, vtxEnd = 0;
+			uint idxBegin = 0, idxEnd = 0;
+			uint cmdBegin = 0, cmdEnd = 0;
+			uint serial = 0;
+		};
+
+		//buffers replaced by a bigger allocation. deleted once the gpu passed their fence
+		struct RetiredStorage {
+			GLuint vbo, ebo, cbo, infobo;
+			GLsync fence;
+		};
+
+		//per draw state of the indirect paths, read as instanced attributes or as std430 ssbo
+		struct DrawInfo {
+			ImVec4 clip;
+			float uvScale[2];
+			GLint layer;
+			GLint pad;
+			GLuint64 handle;
+			GLuint64 pad2;
+		};
+
+		//layout mandated by glMultiDrawElementsIndirect
+		struct DrawElementsIndirectCommand {
+			GLuint count;
+			GLuint instanceCount;
+			GLuint firstIndex;
+			GLint baseVertex;
+			GLuint baseInstance;
+		};
+
+		GLuint VAO = 0, VBO, EBO;
+		//with a Renderer VBO and EBO belong to it and the storage is a slice starting at vtxBase/idxBase.
+		//the vertex binding carries the vertex offset, idxBase is added to every index offset
+		Renderer* renderer = nullptr;
+		bool sharedStorage = false;
+		uint vtxBase = 0, idxBase = 0, vtxSlice = 0, idxSlice = 0;
+		//indirect records and their draw infos, one ring slot per ImDrawCmd
+		GLuint CBO, InfoBO;
+		GLuint tex;
+
+		//user images, one per layer. the uvs of an image are scaled to the part of the layer it covers
+		GLuint imageArray = 0;
+		uint imageWidth = 0, imageHeight = 0, imageLayers = 0;
+		std::vector<ImVec2> imageScales;
+		//bindless handles of the textures the indirect paths sampled so far
+		bool bindless = false;
+		std::unordered_map<GLuint, GLuint64> textureHandles;
+		//texture of every record of the current chunk, a change splits the multi draw without bindless. so does
+		//a change between quads and indexed draws
+		std::vector<GLuint> recordTextures;
+		std::vector<uint8_t> recordQuads;
+
+		GLuint64 textureHandle(GLuint);
+
+		//gl state. by default the shadow is dropped at the start of every frame since the host may have
+		//changed anything in between
+		GLStateCache state;
+		bool persistentState = false, restoreState = false;
+		//queried once in initGL
+		bool clipOriginLowerLeft = true;
+		//layer uniform of the direct program, kept across frames
+		GLint directLayer = -1;
+		uint glCalls = 0;
+
+		void finishFrame(const GLStateCache::State&, uint, uint);
+		GLuint shader;
+		GLuint indirectShader = 0, drawIdShader = 0;
+
+		//retained frame. the gui is rendered into frameTex with premultiplied alpha and composited onto the
+		//host's framebuffer, frames with an unchanged fingerprint only composite
+		bool retainFrame = false;
+		bool dirty = true;
+		GLuint frameFBO = 0, frameTex = 0, compositeShader = 0;
+		uint frameWidth = 0, frameHeight = 0;
+		uint64_t frameHash = 0;
+		ImVec2 frameOrigin;
+
+		//damage tracking. every list keeps one item per command from the last frame they were drawn in,
+		//changed items damage their old and new rect. the damage is kept as disjoint rects so the
+		//redraw never blends a pixel twice
+		struct DamageItem {
+			uint64_t hash;
+			ImVec4 rect;
+		};
+		struct DamageList {
+			uint64_t hash = 0;
+			const ImDrawList* below = nullptr;
+			uint lastSeen = 0;
+			ImVec4 bounds;
+			std::vector<DamageItem> items;
+		};
+		bool damageTracking = false, partialComposite = false;
+		std::unordered_map<const ImDrawList*, DamageList> damageLists;
+		std::vector<DamageItem> damageScratch;
+		//top left origin, [min, max) in pixels
+		std::vector<ImVec4> damage;
+		std::vector<DamageRect> damageRects;
+		float damageArea = 0.f;
+
+		//ImDrawVert or PackedVert, see vertexFormat
+		unsigned char* VBO_ptr;
+		ImDrawIdx* EBO_ptr;
+		DrawElementsIndirectCommand* CBO_ptr;
+		DrawInfo* Info_ptr;
+
+		DrawMode drawMode = Config::Mode;
+		VertexFormat vertexFormat = Config::Format;
+		uint vertSize = Config::Format == VertexFormat::Packed ? (uint)sizeof(PackedVert) : (uint)sizeof(ImDrawVert);
+
+		MapMode mapMode = Config::Map;
+		bool streamingCopy = false;
+
+		//writes vertices to the buffer at _vtx, converting them if needed
+		void copyVertices(uint _vtx, const ImDrawVert* _src, uint _count) {
+			if (packed())
+				packVertices(reinterpret_cast<PackedVert*>(VBO_ptr) + _vtx, _src, _count, streamingCopy);
+			else if (streamingCopy)
+				streamCopy(VBO_ptr + _vtx * (size_t)vertSize, _src, _count * sizeof(ImDrawVert));
+			else
+				std::memcpy(VBO_ptr + _vtx * (size_t)vertSize, _src, _count * sizeof(ImDrawVert));
+		}
+		void copyVertices(uint _vtx, const ImDrawList* _list) {
+			copyVertices(_vtx, _list->VtxBuffer.Data, static_cast<uint>(_list->VtxBuffer.Size));
+		}
+		void copyIndices(uint _idx, const ImDrawIdx* _src, uint _count) {
+			if (streamingCopy)
+				streamCopy(EBO_ptr + _idx, _src, _count * sizeof(ImDrawIdx));
+			else
+				std::memcpy(EBO_ptr + _idx, _src, _count * sizeof(ImDrawIdx));
+		}
+		void copyList(uint _vtx, uint _idx, const ImDrawList* _list) {
+			copyVertices(_vtx, _list);
+			copyIndices(_idx, _list->IdxBuffer.Data, _list->IdxBuffer.Size);
+		}
+
+		//no-op unless the storage is mapped with MapMode::ExplicitFlush
+		void flushMapped(GLuint _buffer, size_t _offset, size_t _bytes) {
+			if (!explicitFlush() || _bytes == 0) return;
+			//copy write, binding the ebo would touch the vao
+			glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+			glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, (GLintptr)_offset, (GLsizeiptr)_bytes);
+			state.calls += 2;
+		}
+
+		//where each list of the current chunk lands in the rings and in the command list. lists drawn
+		//from the arena are not copied, vtxCount and idxCount are what is. quads lists are split into runs
+		struct ListOffset {
+			uint vtx, idx, cmd, vtxCount, idxCount;
+			bool upload, quads;
+		};
+		std::vector<ListOffset> listOffsets;
+
+		//scratch of the current frame, the command lists of all chunks live in it
+		FrameArena frameArena;
+		CommandList cmds;
+
+		std::unique_ptr<WorkerPool> uploadPool;
+		uint parallelThreshold = 1u << 20;
+
+		//ring state. capacity is framesInFlight * upper bound, regions are retired in fifo order
+		uint framesInFlight = 2;
+		uint vtxCapacity = 0, idxCapacity = 0, cmdCapacity = 0;
+		uint vtxHead = 0, idxHead = 0, cmdHead = 0;
+		FrameRegion regions[MaxRegions];
+		uint regionFirst = 0, regionCount = 0, queuedFrames = 0;
+		FrameRegion pending;
+		uint storageGen = 0;
+		std::vector<RetiredStorage> retired;
+
+		//list cache. a list whose hash did not change since the last frame is copied once into the arena
+		//behind the ring and drawn from there until it changes or disappears
+		struct CachedList {
+			uint64_t hash = 0;
+			uint lastSeen = 0;
+			bool resident = false;
+			uint vtx = 0, idx = 0;
+			uint vtxCount = 0, idxCount = 0;
+		};
+		//arena blocks of changed lists, reused once the frame they were freed in completed
+		struct ArenaFree {
+			uint vtx, vtxCount, idx, idxCount;
+			uint serial;
+		};
+		uint arenaVert = 0, arenaIdx = 0;
+		ArenaAllocator vtxArena, idxArena;
+		std::unordered_map<const ImDrawList*, CachedList> listCache;
+		std::vector<ArenaFree> arenaFrees;
+		std::vector<uint64_t> listHashes;
+		std::vector<const CachedList*> listSlots;
+		//frames closed in sync() and frames the gpu finished
+		uint frameSerial = 0, completedSerial = 0;
+
+		void releaseCached(CachedList&);
+		void composite(GLuint, uint, uint);
+		void trackDamage(ImDrawData*, bool);
+		void buildDamageItems(const ImDrawList*, ImDrawData*, std::vector<DamageItem>&, ImVec4&);
+		void mergeCommands(bool, ImVec2, ImVec2, uint, uint);
+		void addDamage(ImVec4);
+		void updateDrawTime();
+		//draw() without the ImGui side, time and renderEnd are set by the caller. _keys identify the lists
+		//across frames, CmdLists if null
+		void render(ImDrawData*, const ImDrawList* const* = nullptr);
+		const ImDrawList* const* listKeys = nullptr;
+
+		//two GL_TIMESTAMP queries around the gl work of a frame. read back in sync() once available, a slot
+		//that is still pending skips the measurement of its frame instead of stalling
+		struct GpuTimer {
+			GLuint queries[2] = { 0, 0 };
+			bool pending = false;
+			uint frame = 0;
+		};
+		GpuTimer gpuTimers[MaxFramesInFlight + 1];
+		uint gpuTimerHead = 0, gpuTimerTail = 0;
+		bool gpuTiming = false, gpuTimerActive = false;
+		float gpuTime = 0.f; //ms
+
+		std::chrono::high_resolution_clock::time_point drawStart;
+		//end of ImGui::Render(), set by draw() or taken from the snapshot
+		std::chrono::high_resolution_clock::time_point renderEnd;
+		//written by begin() on the app thread, copied into time when the frame is drawn
+		std::chrono::high_resolution_clock::time_point beginTime;
+		std::unique_ptr<SnapshotQueue> pipeline;
+		long long uploadTime = 0; //ns
+		CpuPhases cpuPhases;
+
+		//metrics, recorded at the end of sync() and published for other threads
+		Histogram drawTimeHist, syncTimeHist, uploadHist, drawCallHist;
+		uint64_t metricFrames = 0;
+		SeqLock<MetricsSnapshot> metrics;
+
+		//per-frame timeline for the chrome trace export, a ring of traceFrames.size() frames indexed by serial
+		struct FrameRecord {
+			uint frame;
+			double begin, draw, drawEnd, sync, syncEnd; //us since traceEpoch
+			float upload, submit, gpu; //ms
+			uint bytes, draws;
+		};
+		std::vector<FrameRecord> traceFrames;
+		uint traceCount = 0;
+		std::chrono::high_resolution_clock::time_point traceEpoch, drawEnd, syncStart;
+
+		//draw data capture for DrawReplay
+		DrawRecorder recorder;
+
+		FramePacer pacer;
+		bool pacing = false;
+		bool delayedBegin = false;
+		//waitForBegin() already ran for the next begin()
+		bool begun = false;
+		float framePeriod = 0.f; //ms
+		//cap on the frames in flight, 0 leaves it to the ring
+		uint maxQueued = 0;
+		//retires the oldest region, by the prediction of the pacer if it ends a frame
+		void waitFrame();
+
+		void recordMetrics();
+
+		void beginGpuTimer();
+		void endGpuTimer();
+		void readGpuTimers();
+
+		void createStorage();
+		void grow(uint, uint, uint);
+		void retireRegion(bool);
+		void closeRegion(bool);
+		void reserve(uint, uint, uint);
+
+		std::chrono::high_resolution_clock::time_point time;
+		float drawTime = 0.f; //ms
+		std::vector<float> drawTimeMean = std::vector<float>(100);
+		uint drawMeanTimeIndex = 0;
+		float drawTimeSum = 0.f;
+		float meanTime = 0.f;
+
+		uint idxBound, vertBound, cmdBound = 1024;
+		uint idxLimit = 0, vertLimit = 0;
+		uint submits = 0;
+		uint maxIdx = 0, maxVert = 0;
+		uint idx, vert;
+		uint maxFps = 0;
+		uint timeOutSync = static_cast<uint>(5e6);
+		uint syncTime = 0;
+		uint syncTimeOuts = 0;
+		uint drawCalls = 0;
+		uint textureBinds = 0;
+		uint uploadBytes = 0;
+		uint cacheHits = 0, cacheLists = 0;
+		uint cacheSavedBytes = 0;
+
+		bool commandCulling = true;
+		uint culledBytes = 0, mergedDraws = 0;
+
+		//font atlas texture. updates of a few glyphs go through fontPBO
+		std::string fontCache;
+		bool fontFromCache = false, fontRGBA = false;
+		int fontWidth = 0, fontHeight = 0;
+		GLuint fontPBO = 0;
+		size_t fontPBOSize = 0;
+
+		//gpu plots. the samples of a plot live in a coherent persistently mapped ring any thread may append to.
+		//plot() captures the part its frame draws, the ring is twice the plot so pushes rarely wait for a capture
+		struct PlotView {
+			ImVec2 min, max;
+			uint64_t end;
+			uint count;
+			float lo, hi;
+			ImU32 color;
+			PlotMode mode;
+		};
+		struct Plot;
+		//the view of one plot() call, the callback data of its command. it travels with the draw data into a
+		//snapshot and keeps its samples from being overwritten until the gpu passed the frame that drew it
+		struct PlotCapture {
+			Plot* plot;
+			PlotView view;
+			//frame that drew it, NotDrawn before
+			uint serial;
+		};
+		static constexpr uint NotDrawn = ~0u;
+		struct Plot {
+			GLuint samples = 0;
+			float* ptr = nullptr;
+			//samples a plot() draws at most, slots of the ring
+			uint capacity = 0, slots = 0;
+			//pushers reserve samples, then publish them in reservation order
+			std::atomic<uint64_t> reserved{ 0 }, pushed{ 0 };
+			//oldest sample a capture may still read. pushes never reach floor + slots
+			std::atomic<uint64_t> floor{ 0 };
+			std::atomic<uint64_t> dropped{ 0 };
+			std::mutex lock;
+			std::deque<PlotCapture> captures;
+			//min and max per pixel column, written by the decimation
+			GLuint reduced = 0;
+			uint reducedSize = 0;
+		};
+		std::vector<std::unique_ptr<Plot>> plots;
+		GLuint plotShader = 0, decimateShader = 0, plotVAO = 0;
+		std::atomic<uint> plotBytes{ 0 };
+		//marks the commands of plot(), drawPlot() runs instead
+		static void plotCallback(const ImDrawList*, const ImDrawCmd*) {}
+		void drawPlot(const ImDrawCmd*, ImVec2, ImVec2, uint, uint);
+		//releases the captures of frames the gpu finished and moves the floor of every plot up
+		void retirePlots();
+
+		//quad pulling. the commands of an uploaded list are split into runs of at least MinQuadRun quads and runs
+		//of everything else. a run of triangles copies only the vertices it references, the quads of a list go
+		//behind them as PackedQuads
+		struct Segment {
+			//ImDrawCmd of the list and its indices [first, first + count)
+			uint cmd, first, count;
+			//vertices a run of triangles references, relative to VtxOffset. vtxMin > vtxMax references none, the
+			//command was culled or is a callback
+			uint vtxMin, vtxMax;
+			bool quads;
+		};
+		static constexpr uint MinQuadRun = 8;
+		bool quadPulling = false;
+		//per list of the frame, empty if the list is not split
+		std::vector<std::vector<Segment>> listSegments;
+		//per list of the frame, the vertex slots its upload takes at most and the commands it draws, one per
+		//segment of a split list. chunks are sized by these
+		std::vector<uint> listVerts;
+		std::vector<uint> listCmds;
+		GLuint quadShader = 0, quadIndirectShader = 0, quadDrawIdShader = 0;
+		//layer uniform of the direct quad program
+		GLint quadLayer = -1;
+		uint pulledQuads = 0;
+		//vertex slots the PackedQuads of a list take, including the alignment to a PackedQuad
+		uint quadSlots(uint _quads) const {
+			return _quads == 0 ? 0 : static_cast<uint>((_quads * sizeof(PackedQuad) + sizeof(PackedQuad) - 1 + vertSize - 1) / vertSize);
+		}
+		uint scanQuads(const ImDrawList*, std::vector<Segment>&, ImVec2, ImVec2, uint, uint);
+
+		//the indirect path runs callbacks between the multi draws, before the record they were found at
+		struct CallbackPoint {
+			uint record, cmd;
+		};
+		std::vector<CallbackPoint> callbackPoints;
+
+		//directory of the program binary cache and the time initGL took
+		std::string programCache;
+		float initTime = 0.f; //ms
+		uint programCacheHits = 0;
+
+		ImGuiContext* context;
+
+	public:
+		GUI() { context = ImGui::CreateContext(); }
+		~GUI();
+		//upper bounds are per frame. _frames is the number of frames the gpu may lag behind [2, 4]
+		void initGL(uint, uint, uint = 2);
+		//same, but programs, font texture and vertex storage come from _renderer
+		void initGL(Renderer& _renderer, uint, uint, uint = 2);
+		//keeps the linked programs in _dir and loads them from there on the next start. the binaries are keyed
+		//by the driver and the shader sources, rejected ones are compiled again. call before initGL
+		void setProgramCache(const std::string& _dir) {
+			programCache = _dir;
+		}
+		//keeps the built font atlas in _dir and maps it on the next start instead of rasterizing the fonts again.
+		//keyed by the font files and configs added so far. call before initGL
+		void setFontCache(const std::string& _dir) {
+			fontCache = _dir;
+		}
+		//true if initGL restored the font atlas from the font cache
+		bool isFontFromCache() { return fontFromCache; }
+		//uploads a rect of io.Fonts after glyphs changed, the whole atlas if _width or _height is 0. rebuilds the
+		//atlas if needed and recreates the texture if its size changed. call outside begin()/draw()
+		void updateFont(uint _x = 0, uint _y = 0, uint _width = 0, uint _height = 0);
+		//time initGL took, programs included. ms
+		float getInitTime() { return initTime; }
+		//programs initGL loaded from the program cache
+		uint getProgramCacheHits() { return programCacheHits; }
+
+		//ring of _capacity samples drawn by plot(). render thread, after initGL and before the app thread uses it
+		uint createPlot(uint _capacity);
+		//appends samples to a plot, the oldest ones are overwritten. any number of threads. samples that would
+		//overwrite ones a frame in flight still draws are dropped, see getDroppedSamples()
+		void pushPlot(uint _plot, const float* _samples, uint _count);
+		uint64_t getDroppedSamples(uint _plot) { return plots.at(_plot)->dropped.load(std::memory_order_relaxed); }
+		//an item of _size in the current window drawing the last _count samples of a plot (all of them if 0), mapped
+		//from [_min, _max] to the height of the item. the gpu expands the samples into lines or an area and reduces
+		//them to a min/max pair per pixel column if there are more samples than pixels. a 0 _color takes the style
+		//color. one plot() per plot and frame
+		void plot(uint _plot, const ImVec2& _size, float _min, float _max, uint _count = 0, PlotMode _mode = PlotMode::Lines, ImU32 _color = 0);
+		/* use ImGui::GetIO() to set up mouse and keyboard inputs before calling this */
+		void begin();
+		void draw();
+		//draws draw data that was not built with begin(), e.g. a snapshot. does not touch the ImGui context
+		void draw(ImDrawData*);
+		void sync();
+
+		//pipelined mode: the app thread builds frames and hands them to a render thread that owns the GL
+		//context. _depth frames can be queued, 0 turns the mode off. call before the threads start
+		void setPipeline(uint _depth, Backpressure _policy = Backpressure::Block) {
+			pipeline.reset(_depth == 0 ? nullptr : new SnapshotQueue(_depth, _policy));
+		}
+		//app thread, replaces draw(): ImGui::Render() and a snapshot of the draw data into the queue
+		void submit();
+		//render thread: draws the oldest queued frame and calls sync(). false if nothing was queued
+		bool drawQueued();
+		uint getQueuedFrames() { return pipeline ? pipeline->size() : 0; }
+		//frames dropped by Backpressure::DropOldest
+		uint64_t getDroppedFrames() { return pipeline ? pipeline->droppedFrames() : 0; }
+
+		//draws a window with stats
+		void drawStatsWindow(uint = 0);
+		//inserts the stats in an already existing window
+		void drawStats();
+
+		//copies the ImDrawLists on _threads workers plus the render thread once a chunk holds at least
+		//_threshold bytes. 0 threads disables the pool
+		void setUploadThreads(uint _threads, uint _threshold = 1u << 20) {
+			static_assert(Config::UploadThreads, "upload threads are disabled by the config");
+			uploadPool.reset(_threads == 0 ? nullptr : new WorkerPool(_threads));
+			parallelThreshold = _threshold;
+		}
+
+		//size of the arena unchanged lists are kept in, 0 disables the cache. reallocates the storage if
+		//called after initGL
+		void setListCache(uint _vert, uint _idx) {
+			static_assert(Config::ListCache, "the list cache is disabled by the config");
+			arenaVert = _vert;
+			arenaIdx = _idx;
+			if (VAO != 0)
+				grow(vertBound, idxBound, cmdBound);
+		}
+
+		//renders into an offscreen texture that is reused while the draw data does not change. call after initGL
+		void setRetainedFrame(bool);
+		//false if the last draw() only composited the retained frame. hosts can wait for input events until
+		//the gui is dirty again
+		bool isDirty() { return dirty; }
+
+		//only the parts of the retained frame that changed are cleared and redrawn. enables the retained frame.
+		//_partial composites only the damaged rects, the host then has to keep the rest of its framebuffer
+		//intact (e.g. partial swap with a preserved back buffer)
+		void setDamageTracking(bool _track, bool _partial = false) {
+			static_assert(Config::Retained, "the retained frame is disabled by the config");
+			damageTracking = _track;
+			partialComposite = _track && _partial;
+			if (_track && !retainFrame)
+				setRetainedFrame(true);
+			damageLists.clear();
+		}
+		//rects that changed during the last draw(). empty if the frame was reused, the whole framebuffer if
+		//damage tracking is off
+		const std::vector<DamageRect>& getDamageRects() { return damageRects; }
+
+		//keeps the shadow of the gl state across frames. the host then has to call invalidateState() whenever it
+		//changed gl state itself. also skips unbinding everything at the end of draw()
+		void setPersistentState(bool _persistent) {
+			persistentState = _persistent;
+			state.invalidate();
+		}
+		//queries the state TurboGUI touches at the start of draw() and restores it at the end
+		void setRestoreState(bool _restore) {
+			restoreState = _restore;
+		}
+		void invalidateState() {
+			state.invalidate();
+		}
+
+		//allocates the texture array addImage() packs user images into. every layer holds one image of at most
+		//_width x _height. call after initGL, drops the images added so far
+		void setImageArray(uint _width, uint _height, uint _layers);
+		//copies a rgba8 image into the next free layer of the image array. the id goes into ImGui::Image() and
+		//friends with the usual [0, 1] uvs. images of the array batch with the font in the indirect paths
+		ImTextureID addImage(const void* _rgba, uint _width, uint _height);
+
+		//can be switched at any time after initGL
+		void setDrawMode(DrawMode _mode) {
+			static_assert(!Config::FixedDrawMode, "the draw mode is fixed by the config");
+			drawMode = _mode;
+		}
+		DrawMode getDrawMode() { return drawMode; }
+
+		//layout of the vertices on the gpu. reallocates the storage if called after initGL
+		void setVertexFormat(VertexFormat _format) {
+			static_assert(!Config::FixedFormat, "the vertex format is fixed by the config");
+			if (renderer)
+				throw TurboGuiException("the vertex format of a shared storage is set by its Renderer");
+			vertexFormat = _format;
+			vertSize = _format == VertexFormat::Packed ? (uint)sizeof(PackedVert) : (uint)sizeof(ImDrawVert);
+			if (VAO != 0)
+				grow(vertBound, idxBound, cmdBound);
+		}
+		VertexFormat getVertexFormat() { return vertexFormat; }
+
+		//how the storage is mapped. reallocates the storage if called after initGL
+		void setMapMode(MapMode _mode) {
+			static_assert(!Config::FixedMapMode, "the map mode is fixed by the config");
+			if (renderer)
+				throw TurboGuiException("the map mode of a shared storage is set by its Renderer");
+			mapMode = _mode;
+			if (VAO != 0)
+				grow(vertBound, idxBound, cmdBound);
+		}
+		MapMode getMapMode() { return mapMode; }
+
+		//uploads the draw lists with non-temporal stores
+		void setStreamingCopy(bool _stream) {
+			streamingCopy = _stream;
+		}
+
+		//upper bounds the per-frame storage may grow to, 0 means unbounded. frames that do not fit are split into
+		//several submits. the storage always grows enough to hold the largest single ImDrawList.
+		void setGrowthLimit(uint _vert, uint _idx) {
+			vertLimit = _vert;
+			idxLimit = _idx;
+		}
+
+		//sets the timeout of a single wait on a fence in ns. the wait is repeated until the region is free again.
+		void setSyncTimeOut(uint _time) {
+			timeOutSync = _time;
+		}
+
+		//waits for the gpu by the predicted completion of the frame instead of blocking on its fence: a frame due
+		//soon is polled, one due later is slept on. the prediction comes from the fence history, see FramePacer
+		void setFramePacing(bool _pacing) {
+			pacing = _pacing;
+		}
+		//caps the frame rate while pacing, 0 is uncapped. e.g. the refresh rate of the monitor
+		void setTargetFrameRate(float _fps) {
+			framePeriod = _fps > 0.f ? 1000.f / _fps : 0.f;
+		}
+		//frames the cpu may run ahead of the gpu. 0 caps nothing, sync() then only waits when the ring wraps into
+		//a region still in flight. fewer frames less latency
+		void setMaxQueuedFrames(uint _frames) {
+			maxQueued = _frames;
+		}
+		//while pacing, begin() starts the frame as late as the gpu and the frame rate target allow, so the input
+		//sampled before it is as fresh as possible. see waitForBegin()
+		void setDelayedBegin(bool _delayed) {
+			delayedBegin = _delayed;
+		}
+		//the wait of a delayed begin(). call it before polling the input, begin() calls it otherwise
+		void waitForBegin();
+		PacingStats getPacingStats() { return pacer.getStats(); }
+
+		uint getIdxCount() { return idx; }
+		uint getVertCount() { return vert; }
+		uint getSyncTime() { return syncTime; }
+		//number of wait slices that ran into the timeout since initGL
+		uint getSyncTimeOuts() { return syncTimeOuts; }
+		uint getFramesInFlight() { return queuedFrames; }
+		//current per-frame bounds, these grow with the draw data
+		uint getVertBound() { return vertBound; }
+		uint getIdxBound() { return idxBound; }
+		//number of chunks the last frame was split into
+		uint getSubmitCount() { return submits; }
+		uint getDrawCallCount() { return drawCalls; }
+		//gl calls issued by the last draw(), draws included
+		uint getGLCallCount() { return glCalls; }
+		//glBindTexture calls of the last draw()
+		uint getTextureBindCount() { return textureBinds; }
+		//true if the indirect paths sample through ARB_bindless_texture handles
+		bool hasBindlessTextures() { return bindless; }
+		//bytes written into the mapped buffers during the last draw()
+		uint getUploadBytes() { return uploadBytes; }
+		//share of the last frame's lists drawn from the list cache
+		float getCacheHitRate() { return cacheLists == 0 ? 0.f : static_cast<float>(cacheHits) / cacheLists; }
+		//bytes the list cache saved during the last draw()
+		uint getCacheBytesSaved() { return cacheSavedBytes; }
+
+		//runs of axis aligned quads (text, rects) go to the gpu as one 20 byte PackedQuad each instead of 4 vertices
+		//and 6 indices and are expanded in the vertex shader from gl_VertexID. quads are snapped like
+		//VertexFormat::Packed, everything else keeps the indexed path. lists drawn from the list cache are not split
+		void setQuadPulling(bool _pull) {
+			static_assert(Config::QuadPulling, "quad pulling is disabled by the config");
+			quadPulling = _pull;
+		}
+		//quads pulled during the last draw()
+		uint getPulledQuads() { return pulledQuads; }
+
+		//skips the indices of commands outside the framebuffer during the upload and merges neighbouring
+		//commands that draw like one. on by default
+		void setCommandCulling(bool _cull) {
+			commandCulling = _cull;
+		}
+		//index and vertex bytes culling kept out of the last upload
+		uint getCulledBytes() { return culledBytes; }
+		//draws saved by merging commands during the last draw()
+		uint getMergedDraws() { return mergedDraws; }
+		float getDrawTime() { return drawTime; }
+		float getMeanDrawTime() { return meanTime; }
+		CpuPhases getCpuPhases() { return cpuPhases; }
+
+		//measures the gl work of every frame with timestamp queries. call after initGL
+		void setGpuTiming(bool);
+		//gpu time of the most recent frame whose queries came back, usually a few frames old. ms
+		float getGpuTime() { return gpuTime; }
+
+		//percentiles since the last resetMetrics(). safe to call from any thread
+		MetricsSnapshot getMetrics() const { return metrics.load(); }
+		void resetMetrics();
+		//one line per metric: metric,count,mean,p50,p95,p99,max. safe to call from any thread
+		void exportMetricsCSV(std::ostream&) const;
+		//keeps the timeline of the last _frames frames for exportChromeTrace(), 0 disables it
+		void setTraceCapture(uint _frames);
+		//chrome://tracing / perfetto json of the captured frames. render thread only
+		void exportChromeTrace(std::ostream&) const;
+
+		//writes the ImDrawData of every frame drawn from now on to _path, see DrawReplay. an empty path ends the
+		//capture. false if the file could not be created
+		bool setDrawCapture(const std::string& _path) {
+			recorder.close();
+			return _path.empty() || recorder.open(_path);
+		}
+		//frames written by the current or last capture
+		uint getCapturedFrames() { return recorder.getFrames(); }
+		//true if the current or last capture ended early because a frame exceeded 4 GiB or a write failed
+		bool isDrawCaptureFailed() const { return recorder.isFailed(); }
+
+		ImGuiContext* getContext() { return context; }
+	};
+
+}
+
+template<class Config>
+inline TurboGUI::GUI<Config>::~GUI() {
+    glDeleteVertexArrays(1, &VAO);
+    if (sharedStorage)
+        renderer->release(vtxBase, vtxSlice, idxBase, idxSlice);
+    else {
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+    glDeleteBuffers(1, &CBO);
+    glDeleteBuffers(1, &InfoBO);
+    glDeleteBuffers(1, &fontPBO);
+    //the font of a renderer may still be sampled by other GUIs through the same handle
+    for (const auto& h : textureHandles)
+        if (!renderer || h.first != tex)
+            glMakeTextureHandleNonResidentARB(h.second);
+    if (renderer) {
+        renderer->releaseFont(tex);
+        --renderer->guis;
+    } else {
+        glDeleteProgram(shader);
+        glDeleteProgram(indirectShader);
+        glDeleteProgram(drawIdShader);
+        glDeleteProgram(compositeShader);
+        glDeleteProgram(plotShader);
+        glDeleteProgram(decimateShader);
+        glDeleteProgram(quadShader);
+        glDeleteProgram(quadIndirectShader);
+        glDeleteProgram(quadDrawIdShader);
+        glDeleteTextures(1, &tex);
+    }
+    for (const auto& p : plots) {
+        glDeleteBuffers(1, &p->samples);
+        glDeleteBuffers(1, &p->reduced);
+    }
+    glDeleteVertexArrays(1, &plotVAO);
+    glDeleteTextures(1, &imageArray);
+    glDeleteTextures(1, &frameTex);
+    glDeleteFramebuffers(1, &frameFBO);
+    for (GpuTimer& t : gpuTimers)
+        glDeleteQueries(2, t.queries);
+    for (uint i = 0; i < regionCount; ++i)
+        glDeleteSync(regions[(regionFirst + i) % MaxRegions].fence);
+    for (const RetiredStorage& r : retired) {
+        glDeleteBuffers(1, &r.vbo);
+        glDeleteBuffers(1, &r.ebo);
+        glDeleteBuffers(1, &r.cbo);
+        glDeleteBuffers(1, &r.infobo);
+        glDeleteSync(r.fence);
+    }
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::initGL(Renderer& _renderer, uint _vbo_upper_bound, uint _ebo_upper_bound, uint _frames) {
+    if (Config::FixedFormat && _renderer.vertexFormat != Config::Format)
+        throw TurboGuiException("the vertex format of the renderer differs from the one fixed by the config");
+    if (Config::FixedMapMode && _renderer.mapMode != Config::Map)
+        throw TurboGuiException("the map mode of the renderer differs from the one fixed by the config");
+    renderer = &_renderer;
+    vertexFormat = _renderer.vertexFormat;
+    vertSize = _renderer.vertSize;
+    mapMode = _renderer.mapMode;
+    ++_renderer.guis;
+    initGL(_vbo_upper_bound, _ebo_upper_bound, _frames);
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::initGL(uint _vbo_upper_bound, uint _ebo_upper_bound, uint _frames) {
+
+    if constexpr (Config::FramesInFlight != 0)
+        _frames = Config::FramesInFlight;
+    if (_frames < 2 || _frames > MaxFramesInFlight)
+        throw TurboGuiException("frames in flight must be in [2, " + std::to_string(MaxFramesInFlight) + "]");
+
+    const auto start = clock();
+
+    std::memset(drawTimeMean.data(), 0, drawTimeMean.size() * sizeof(float));
+    drawTimeSum = 0.f;
+
+    ImGui::SetCurrentContext(context);
+
+    {
+        ImGuiIO& io = ImGui::GetIO();
+        io.BackendRendererName = "turbogui";
+        //lists above 64k vertices are rebased by ImGui through ImDrawCmd::VtxOffset
+        io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    }
+
+    {
+        ImGuiIO& io = ImGui::GetIO();
+        if (renderer)
+            tex = renderer->acquireFont(io.Fonts, fontFromCache);
+        else {
+            MappedFile file;
+            const FontPixels pixels = buildFont(io.Fonts, fontCache, file);
+            tex = createFontTexture(pixels);
+            fontWidth = pixels.width;
+            fontHeight = pixels.height;
+            fontRGBA = pixels.rgba;
+            fontFromCache = pixels.cached;
+        }
+        io.Fonts->SetTexID((ImTextureID)(intptr_t)tex);
+    }
+
+    idxBound = _ebo_upper_bound;
+    vertBound = _vbo_upper_bound;
+    framesInFlight = _frames;
+
+    //vertex layout. the buffers and the vertex formats are set in createStorage() so they can be swapped
+    //when growing
+    glGenVertexArrays(1, &VAO);
+    {
+        glBindVertexArray(VAO);
+
+        //pos, uv, col
+        for (GLuint a = 0; a < 3; ++a) {
+            glVertexAttribBinding(a, 0);
+            glEnableVertexAttribArray(a);
+        }
+
+        //draw info of the indirect path, one per instance. baseInstance selects the record
+        glVertexAttribFormat(3, 4, GL_FLOAT, GL_FALSE, IM_OFFSETOF(DrawInfo, clip));
+        glVertexAttribBinding(3, 1);
+        glEnableVertexAttribArray(3);
+
+        glVertexAttribFormat(4, 2, GL_FLOAT, GL_FALSE, IM_OFFSETOF(DrawInfo, uvScale));
+        glVertexAttribBinding(4, 1);
+        glEnableVertexAttribArray(4);
+
+        glVertexAttribIFormat(5, 1, GL_INT, IM_OFFSETOF(DrawInfo, layer));
+        glVertexAttribBinding(5, 1);
+        glEnableVertexAttribArray(5);
+
+        glVertexAttribIFormat(6, 2, GL_UNSIGNED_INT, IM_OFFSETOF(DrawInfo, handle));
+        glVertexAttribBinding(6, 1);
+        glEnableVertexAttribArray(6);
+
+        glVertexBindingDivisor(1, 1);
+
+        glBindVertexArray(0);
+    }
+
+    createStorage();
+
+#if defined(GL_CLIP_ORIGIN) && !defined(__APPLE__)
+    if constexpr (Config::Origin == ClipOrigin::Query) {
+        GLenum clip_origin = 0;
+        glGetIntegerv(GL_CLIP_ORIGIN, (GLint*)&clip_origin);
+        clipOriginLowerLeft = clip_origin != GL_UPPER_LEFT;
+    }
+#endif
+
+    {
+        Programs p;
+        if (renderer)
+            p = renderer->programs;
+        else {
+            p.cache = programCache;
+            p.create();
+            programCacheHits = p.cacheHits;
+        }
+        shader = p.shader;
+        indirectShader = p.indirect;
+        drawIdShader = p.drawId;
+        compositeShader = p.composite;
+        bindless = p.bindless;
+    }
+
+    state.invalidate();
+    initTime = std::chrono::duration<float, std::milli>(clock() - start).count();
+
+}
+
+inline void TurboGUI::Programs::create() {
+    bindless = GLAD_GL_ARB_bindless_texture != 0;
+    createDrawPrograms(false, shader, indirect, drawId);
+
+    //retained frame: one fullscreen triangle, the texture holds premultiplied colors
+    {
+        const GLchar* vertex_shader =
+            "#version 430 core\n"
+            "void main()\n"
+            "{\n"
+            "    gl_Position = vec4(gl_VertexID == 1 ? 3.f : -1.f, gl_VertexID == 2 ? 3.f : -1.f, 0.f, 1.f);\n"
+            "}\n";
+
+        const GLchar* fragment_shader =
+            "#version 430 core\n"
+            "layout (location = 4) uniform sampler2D Frame;\n"
+            "out vec4 Out_Color;\n"
+            "void main()\n"
+            "{\n"
+            "    Out_Color = texelFetch(Frame, ivec2(gl_FragCoord.xy), 0);\n"
+            "}\n";
+
+        composite = build(vertex_shader, fragment_shader);
+    }
+}
+
+inline void TurboGUI::Programs::createQuads() {
+    if (quadShader != 0) return;
+    createDrawPrograms(true, quadShader, quadIndirect, quadDrawId);
+}
+
+inline void TurboGUI::Programs::createDrawPrograms(bool _quads, GLuint& _shader, GLuint& _indirect, GLuint& _drawId) {
+    //the vertex inputs. quads are pulled from the vertex storage bound as a storage buffer, gl_VertexID / 6 is
+    //the quad and the corners follow ImDrawList::PrimRectUV, 0 1 2 0 2 3. same fixed point as PackedVert
+    const std::string input = _quads ?
+        "layout (std430, binding = 3) readonly buffer Quads { uint quads[]; };\n"
+        "vec2 Position;\n"
+        "vec2 UV;\n"
+        "vec4 Color;\n"
+        "void pull()\n"
+        "{\n"
+        "    uint q = uint(gl_VertexID) / 6u * 5u, k = uint(gl_VertexID) % 6u;\n"
+        "    uint corner = k < 3u ? k : k == 3u ? 0u : k - 2u;\n"
+        "    bool right = corner == 1u || corner == 2u, bottom = corner >= 2u;\n"
+        "    uint a = quads[q], c = quads[q + 1u];\n"
+        "    Position = vec2(float(int((right ? c : a) << 16) >> 16), float(int(bottom ? c : a) >> 16));\n"
+        "    vec2 uva = unpackUnorm2x16(quads[q + 2u]), uvc = unpackUnorm2x16(quads[q + 3u]);\n"
+        "    UV = vec2(right ? uvc.x : uva.x, bottom ? uvc.y : uva.y);\n"
+        "    Color = unpackUnorm4x8(quads[q + 4u]);\n"
+        "}\n" :
+        "layout (location = 0) in vec2 Position;\n"
+        "layout (location = 1) in vec2 UV;\n"
+        "layout (location = 2) in vec4 Color;\n";
+    const std::string pull = _quads ? "    pull();\n" : "";
+
+    {
+        const std::string vertex_shader =
+            "#version 430 core\n" + input +
+            "layout (location = 3) uniform mat4 ProjMtx;\n"
+            "layout (location = 8) uniform vec2 UVScale;\n"
+            "out vec2 Frag_UV;\n"
+            "out vec4 Frag_Color;\n"
+            "void main()\n"
+            "{\n" + pull +
+            "    Frag_UV = UV * UVScale;\n"
+            "    Frag_Color = Color;\n"
+            "    gl_Position = ProjMtx * vec4(Position.xy,0.f,1.f);\n"
+            "}\n";
+
+        const GLchar* fragment_shader =
+            "#version 430 core\n"
+            "in vec2 Frag_UV;\n"
+            "in vec4 Frag_Color;\n"
+            "layout (location = 4) uniform sampler2D Texture;\n"
+            "layout (location = 6) uniform sampler2DArray Images;\n"
+            "layout (location = 7) uniform int Layer;\n"
+            "out vec4 Out_Color;\n"
+            "void main()\n"
+            "{\n"
+            "    Out_Color = Frag_Color * (Layer < 0 ? texture(Texture, Frag_UV.xy) : texture(Images, vec3(Frag_UV.xy, Layer)));\n"
+            "}\n";
+
+        _shader = build(vertex_shader.c_str(), fragment_shader);
+        glProgramUniform1i(_shader, 6, 1);
+        glProgramUniform1i(_shader, 7, -1);
+        glProgramUniform2f(_shader, 8, 1.f, 1.f);
+    }
+
+    //indirect path: the scissor test is replaced by a test against the per-draw clip rect in window coordinates.
+    //with bindless textures every record carries the handle of its texture, so texture changes do not split the batch
+    {
+        const std::string header = bindless ?
+            "#version 430 core\n"
+            "#extension GL_ARB_bindless_texture : require\n"
+            "#define BINDLESS\n" :
+            "#version 430 core\n";
+
+        const std::string vertex_shader = header + input +
+            "layout (location = 3) in vec4 Clip;\n"
+            "layout (location = 4) in vec2 UVScale;\n"
+            "layout (location = 5) in int Layer;\n"
+            "layout (location = 6) in uvec2 Handle;\n"
+            "layout (location = 3) uniform mat4 ProjMtx;\n"
+            "out vec2 Frag_UV;\n"
+            "out vec4 Frag_Color;\n"
+            "flat out vec4 Frag_Clip;\n"
+            "flat out int Frag_Layer;\n"
+            "flat out uvec2 Frag_Handle;\n"
+            "void main()\n"
+            "{\n" + pull +
+            "    Frag_UV = UV * UVScale;\n"
+            "    Frag_Color = Color;\n"
+            "    Frag_Clip = Clip;\n"
+            "    Frag_Layer = Layer;\n"
+            "    Frag_Handle = Handle;\n"
+            "    gl_Position = ProjMtx * vec4(Position.xy,0.f,1.f);\n"
+            "}\n";
+
+        const std::string vertex_shader_draw_id = header +
+            "#extension GL_ARB_shader_draw_parameters : require\n" + input +
+            "layout (location = 3) uniform mat4 ProjMtx;\n"
+            "layout (location = 5) uniform int InfoBase;\n"
+            "struct DrawInfo { vec4 clip; vec2 uvScale; int layer; int pad; uvec2 handle; uvec2 pad2; };\n"
+            "layout (std430, binding = 0) readonly buffer DrawInfos { DrawInfo infos[]; };\n"
+            "out vec2 Frag_UV;\n"
+            "out vec4 Frag_Color;\n"
+            "flat out vec4 Frag_Clip;\n"
+            "flat out int Frag_Layer;\n"
+            "flat out uvec2 Frag_Handle;\n"
+            "void main()\n"
+            "{\n" + pull +
+            "    DrawInfo info = infos[InfoBase + gl_DrawIDARB];\n"
+            "    Frag_UV = UV * info.uvScale;\n"
+            "    Frag_Color = Color;\n"
+            "    Frag_Clip = info.clip;\n"
+            "    Frag_Layer = info.layer;\n"
+            "    Frag_Handle = info.handle;\n"
+            "    gl_Position = ProjMtx * vec4(Position.xy,0.f,1.f);\n"
+            "}\n";
+
+        const std::string fragment_shader = header +
+            "in vec2 Frag_UV;\n"
+            "in vec4 Frag_Color;\n"
+            "flat in vec4 Frag_Clip;\n"
+            "flat in int Frag_Layer;\n"
+            "flat in uvec2 Frag_Handle;\n"
+            "layout (location = 4) uniform sampler2D Texture;\n"
+            "layout (location = 6) uniform sampler2DArray Images;\n"
+            "out vec4 Out_Color;\n"
+            "void main()\n"
+            "{\n"
+            "    if (any(lessThan(gl_FragCoord.xy, Frag_Clip.xy)) || any(greaterThanEqual(gl_FragCoord.xy, Frag_Clip.zw))) discard;\n"
+            "#ifdef BINDLESS\n"
+            "    vec4 texel = Frag_Layer < 0 ? texture(sampler2D(Frag_Handle), Frag_UV.xy) : texture(Images, vec3(Frag_UV.xy, Frag_Layer));\n"
+            "#else\n"
+            "    vec4 texel = Frag_Layer < 0 ? texture(Texture, Frag_UV.xy) : texture(Images, vec3(Frag_UV.xy, Frag_Layer));\n"
+            "#endif\n"
+            "    Out_Color = Frag_Color * texel;\n"
+            "}\n";
+
+        _indirect = build(vertex_shader.c_str(), fragment_shader.c_str());
+        glProgramUniform1i(_indirect, 6, 1);
+        if (GLAD_GL_ARB_shader_draw_parameters) {
+            _drawId = build(vertex_shader_draw_id.c_str(), fragment_shader.c_str());
+            glProgramUniform1i(_drawId, 6, 1);
+        }
+    }
+}
+
+inline void TurboGUI::Programs::createPlot() {
+    if (plot != 0) return;
+    {
+        //one vertex per sample, or a min/max pair per pixel column of the reduced samples. areas alternate
+        //between the sample and the bottom of the range
+        const GLchar* vertex_shader =
+            "#version 430 core\n"
+            "layout (std430, binding = 1) readonly buffer Samples { float samples[]; };\n"
+            "layout (location = 0) uniform vec4 Rect;\n"
+            "layout (location = 1) uniform uint Start;\n"
+            "layout (location = 2) uniform uint Capacity;\n"
+            "layout (location = 3) uniform uint Count;\n"
+            "layout (location = 4) uniform vec2 Range;\n"
+            "layout (location = 5) uniform int Mode;\n"
+            "void main()\n"
+            "{\n"
+            "    uint i = uint(gl_VertexID);\n"
+            "    uint p = Mode == 0 ? i : i / 2u;\n"
+            "    bool bottom = (Mode & 1) == 1 && (i & 1u) == 1u;\n"
+            "    float x = Mode < 2 ? float(p) / float(Count - 1u) : (float(p) + 0.5) / float(Count);\n"
+            "    float v = Mode == 2 ? samples[i] : Mode == 3 ? samples[p * 2u + 1u] : samples[(Start + p) % Capacity];\n"
+            "    float y = bottom ? 0.0 : clamp((v - Range.x) / (Range.y - Range.x), 0.0, 1.0);\n"
+            "    gl_Position = vec4(mix(Rect.x, Rect.z, x), mix(Rect.y, Rect.w, y), 0.0, 1.0);\n"
+            "}\n";
+
+        const GLchar* fragment_shader =
+            "#version 430 core\n"
+            "layout (location = 6) uniform vec4 Color;\n"
+            "out vec4 Out_Color;\n"
+            "void main()\n"
+            "{\n"
+            "    Out_Color = Color;\n"
+            "}\n";
+
+        plot = build(vertex_shader, fragment_shader);
+    }
+    {
+        //min and max of the samples of every pixel column, the first Count % Columns columns take one more
+        const GLchar* compute_shader =
+            "#version 430 core\n"
+            "layout (local_size_x = 64) in;\n"
+            "layout (std430, binding = 1) readonly buffer Samples { float samples[]; };\n"
+            "layout (std430, binding = 2) writeonly buffer Reduced { vec2 reduced[]; };\n"
+            "layout (location = 1) uniform uint Start;\n"
+            "layout (location = 2) uniform uint Capacity;\n"
+            "layout (location = 3) uniform uint Count;\n"
+            "layout (location = 7) uniform uint Columns;\n"
+            "void main()\n"
+            "{\n"
+            "    uint c = gl_GlobalInvocationID.x;\n"
+            "    if (c >= Columns) return;\n"
+            "    uint q = Count / Columns, r = Count % Columns;\n"
+            "    uint b = c * q + min(c, r);\n"
+            "    uint e = b + q + (c < r ? 1u : 0u);\n"
+            "    float lo = samples[(Start + b) % Capacity], hi = lo;\n"
+            "    for (uint i = b + 1u; i < e; ++i) {\n"
+            "        float v = samples[(Start + i) % Capacity];\n"
+            "        lo = min(lo, v);\n"
+            "        hi = max(hi, v);\n"
+            "    }\n"
+            "    reduced[c] = vec2(lo, hi);\n"
+            "}\n";
+
+        decimate = build(compute_shader, nullptr);
+    }
+}
+
+inline void TurboGUI::Programs::destroy() {
+    glDeleteProgram(shader);
+    glDeleteProgram(indirect);
+    glDeleteProgram(drawId);
+    glDeleteProgram(composite);
+    glDeleteProgram(quadShader);
+    glDeleteProgram(quadIndirect);
+    glDeleteProgram(quadDrawId);
+    glDeleteProgram(plot);
+    glDeleteProgram(decimate);
+}
+
+inline GLuint TurboGUI::Programs::build(const GLchar* _vertex_shader, const GLchar* _fragment_shader) {
+    GLint formats = 0;
+    if (!cache.empty())
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats == 0)
+        return compileProgram(_vertex_shader, _fragment_shader);
+
+    //a driver update or a changed shader gives a new file instead of a rejected binary
+    uint64_t key = 0;
+    for (const GLubyte* str : { glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION) })
+        key = hashBytes(str, std::strlen(reinterpret_cast<const char*>(str)), key);
+    key = hashBytes(_vertex_shader, std::strlen(_vertex_shader), key);
+    if (_fragment_shader)
+        key = hashBytes(_fragment_shader, std::strlen(_fragment_shader), key);
+    char name[32];
+    std::snprintf(name, sizeof(name), "/tbgui_%016llx.bin", static_cast<unsigned long long>(key));
+    const std::string path = cache + name;
+
+    //file: the binary format followed by the binary
+    {
+        std::ifstream in(path, std::ios::binary);
+        GLenum format = 0;
+        std::vector<char> binary;
+        if (in.read(reinterpret_cast<char*>(&format), sizeof(format)))
+            binary.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+        std::vector<GLint> supported(formats);
+        glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, supported.data());
+        if (!binary.empty() && std::find(supported.begin(), supported.end(), (GLint)format) != supported.end()) {
+            GLuint program = glCreateProgram();
+            glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+            GLint linked = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+            if (linked == GL_TRUE) {
+                ++cacheHits;
+                return program;
+            }
+            glDeleteProgram(program);
+        }
+    }
+
+    const GLuint program = compileProgram(_vertex_shader, _fragment_shader, true);
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length > 0) {
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+        //written next to the target and renamed, a crash or a concurrent start never loads a truncated binary.
+        //a cache that cannot be written only costs the next start
+        const std::string tmp = tempPath(path);
+        bool written;
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&format), sizeof(format));
+            out.write(binary.data(), length);
+            written = static_cast<bool>(out.flush());
+        }
+        if (written)
+            replaceFile(tmp, path);
+        else
+            std::remove(tmp.c_str());
+    }
+    return program;
+}
+
+inline GLuint TurboGUI::createFontTexture(const FontPixels& _pixels) {
+    GLuint t;
+    glGenTextures(1, &t);
+    glBindTexture(GL_TEXTURE_2D, t);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    if (_pixels.rgba)
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _pixels.width, _pixels.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, _pixels.data);
+    else {
+        const GLint swizzle[4] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, _pixels.width, _pixels.height, 0, GL_RED, GL_UNSIGNED_BYTE, _pixels.data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    return t;
+}
+
+inline TurboGUI::Renderer::Renderer(uint _vert, uint _idx, VertexFormat _format, MapMode _mode, const std::string& _programCache) :
+    vertexFormat(_format), vertSize(_format == VertexFormat::Packed ? (uint)sizeof(PackedVert) : (uint)sizeof(ImDrawVert)),
+    mapMode(_mode), vtxCapacity(_vert), idxCapacity(_idx) {
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    programs.cache = _programCache;
+    programs.create();
+
+    GLbitfield storageFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_CLIENT_STORAGE_BIT;
+    GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    if (mapMode == MapMode::Coherent) {
+        storageFlags |= GL_MAP_COHERENT_BIT;
+        mapFlags |= GL_MAP_COHERENT_BIT;
+    } else if (mapMode == MapMode::ExplicitFlush)
+        mapFlags |= GL_MAP_FLUSH_EXPLICIT_BIT;
+
+    //copy write, binding the ebo would touch whatever vao is bound
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, vtxCapacity * (GLsizeiptr)vertSize, nullptr, storageFlags);
+    VBO_ptr = reinterpret_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, vtxCapacity * (GLsizeiptr)vertSize, mapFlags));
+
+    glGenBuffers(1, &EBO);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, idxCapacity * (GLsizeiptr)sizeof(ImDrawIdx), nullptr, storageFlags);
+    EBO_ptr = reinterpret_cast<ImDrawIdx*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, idxCapacity * (GLsizeiptr)sizeof(ImDrawIdx), mapFlags));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (!VBO_ptr || !EBO_ptr)
+        throw TurboGuiException("failed to map the shared vertex storage");
+
+    vtxSlices.reset(vtxCapacity);
+    idxSlices.reset(idxCapacity);
+    initTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+inline TurboGUI::Renderer::~Renderer() {
+    programs.destroy();
+    for (const auto& f : fonts)
+        glDeleteTextures(1, &f.second.tex);
+    for (const RetiredSlice& r : retired)
+        glDeleteSync(r.fence);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+inline GLuint TurboGUI::Renderer::acquireFont(ImFontAtlas* _atlas, bool& _cached) {
+    MappedFile file;
+    const FontPixels pixels = buildFont(_atlas, fontCache, file);
+    _cached = pixels.cached;
+    uint64_t h = hashBytes(pixels.data, (size_t)pixels.width * pixels.height * (pixels.rgba ? 4 : 1), 0);
+    const int dims[3] = { pixels.width, pixels.height, pixels.rgba };
+    h = hashBytes(dims, sizeof(dims), h);
+
+    auto it = fonts.find(h);
+    if (it == fonts.end())
+        it = fonts.emplace(h, Font{ createFontTexture(pixels), 0 }).first;
+    ++it->second.refs;
+    return it->second.tex;
+}
+
+inline void TurboGUI::Renderer::releaseFont(GLuint _tex) {
+    for (auto it = fonts.begin(); it != fonts.end(); ++it) {
+        if (it->second.tex != _tex) continue;
+        if (--it->second.refs == 0) {
+            glDeleteTextures(1, &_tex);
+            fonts.erase(it);
+        }
+        return;
+    }
+}
+
+inline bool TurboGUI::Renderer::allocate(uint _vtx, uint _idx, uint& _vtxOffset, uint& _idxOffset) {
+    collect();
+    if (!vtxSlices.alloc(_vtx, _vtxOffset))
+        return false;
+    if (!idxSlices.alloc(_idx, _idxOffset)) {
+        vtxSlices.release(_vtxOffset, _vtx);
+        return false;
+    }
+    ++slices;
+    return true;
+}
+
+inline void TurboGUI::Renderer::release(uint _vtx, uint _vtxCount, uint _idx, uint _idxCount) {
+    retired.push_back({ _vtx, _vtxCount, _idx, _idxCount, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    --slices;
+}
+
+inline void TurboGUI::Renderer::collect() {
+    for (size_t i = 0; i < retired.size();) {
+        const GLenum res = glClientWaitSync(retired[i].fence, 0, 0);
+        if (res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED) {
+            vtxSlices.release(retired[i].vtx, retired[i].vtxCount);
+            idxSlices.release(retired[i].idx, retired[i].idxCount);
+            glDeleteSync(retired[i].fence);
+            retired[i] = retired.back();
+            retired.pop_back();
+        } else
+            ++i;
+    }
+}
+
+inline GLuint TurboGUI::compileProgram(const GLchar* _vertex_shader, const GLchar* _fragment_shader, bool _retrievable) {
+    //Compile Vertex
+    GLuint vertex = glCreateShader(_fragment_shader ? GL_VERTEX_SHADER : GL_COMPUTE_SHADER);
+    glShaderSource(vertex, 1, &_vertex_shader, nullptr);
+    glCompileShader(vertex);
+    GLint isCompiled = 0;
+    glGetShaderiv(vertex, GL_COMPILE_STATUS, &isCompiled);
+    if (isCompiled == GL_FALSE) {
+        GLint maxLength = 0;
+        glGetShaderiv(vertex, GL_INFO_LOG_LENGTH, &maxLength);
+        std::vector<GLchar> errorLog(maxLength);
+        glGetShaderInfoLog(vertex, maxLength, &maxLength, &errorLog[0]);
+        glDeleteShader(vertex);
+        throw TurboGuiException(std::string(errorLog.data()));
+    }
+
+    //Compile Frag
+    GLuint frag = 0;
+    if (_fragment_shader) {
+        frag = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(frag, 1, &_fragment_shader, nullptr);
+        glCompileShader(frag);
+        isCompiled = 0;
+        glGetShaderiv(frag, GL_COMPILE_STATUS, &isCompiled);
+    }
+    if (_fragment_shader && isCompiled == GL_FALSE) {
+        GLint maxLength = 0;
+        glGetShaderiv(frag, GL_INFO_LOG_LENGTH, &maxLength);
+        std::vector<GLchar> errorLog(maxLength);
+        glGetShaderInfoLog(frag, maxLength, &maxLength, &errorLog[0]);
+        glDeleteShader(vertex);
+        glDeleteShader(frag);
+        throw TurboGuiException(std::string(errorLog.data()));
+    }
+
+    //Link
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    if (frag != 0)
+        glAttachShader(program, frag);
+    if (_retrievable)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    glLinkProgram(program);
+
+    GLint isLinked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, (int*)&isLinked);
+    if (isLinked == GL_FALSE) {
+        GLint maxLength = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
+        std::vector<GLchar> errorLog(maxLength);
+        glGetProgramInfoLog(program, maxLength, &maxLength, &errorLog[0]);
+        glDeleteShader(vertex);
+        glDeleteShader(frag);
+        glDeleteProgram(program);
+        throw TurboGuiException(std::string(errorLog.data()));
+    }
+
+    glDetachShader(program, vertex);
+    if (frag != 0)
+        glDetachShader(program, frag);
+    glDeleteShader(vertex);
+    glDeleteShader(frag);
+
+    return program;
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::begin() {
+    if (!begun) waitForBegin();
+    begun = false;
+    if (pacing && !pipeline)
+        pacer.begin(frameSerial, FramePacer::Clock::now());
+    beginTime = clock();
+    ImGui::SetCurrentContext(context);
+    ImGui::NewFrame();   
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::submit() {
+    ImGui::Render();
+    pipeline->push(ImGui::GetDrawData(), beginTime);
+}
+
+template<class Config>
+inline bool TurboGUI::GUI<Config>::drawQueued() {
+    DrawDataSnapshot* snap = pipeline ? pipeline->pop() : nullptr;
+    if (!snap) return false;
+    time = snap->beginTime;
+    renderEnd = snap->renderTime;
+    render(snap->get(), snap->keys());
+    sync();
+    return true;
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::draw() {
+    ImGui::Render();
+    time = beginTime;
+    renderEnd = clock();
+    render(ImGui::GetDrawData());
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::draw(ImDrawData* _drawData) {
+    time = renderEnd = clock();
+    render(_drawData);
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::render(ImDrawData* _drawData, const ImDrawList* const* _keys) {
+
+    drawStart = clock();
+    cpuPhases.imgui = std::chrono::duration<float, std::milli>(renderEnd - time).count();
+    uploadTime = 0;
+
+    auto draw_data = _drawData;
+    listKeys = _keys ? _keys : draw_data->CmdLists;
+    if (recorder.isOpen())
+        recorder.record(draw_data, listKeys, (ImTextureID)(intptr_t)tex);
+
+    const ImVec2 clip_off = draw_data->DisplayPos;         // (0,0) unless using multi-viewports
+    const ImVec2 clip_scale = draw_data->FramebufferScale; // (1,1) unless using retina display which are often (2,2)
+
+    syncTime = 0;
+
+    state.calls = 0;
+    state.textureBinds = 0;
+    GLStateCache::State saved;
+    if (restoreState)
+        saved = state.save();
+    else if (!persistentState)
+        state.invalidate();
+
+    beginGpuTimer();
+
+    idx = 0;
+    vert = 0;
+    drawCalls = 0;
+    submits = 0;
+    //samples pushed into the plot rings since the last frame
+    uploadBytes = plotBytes.exchange(0);
+    cacheHits = 0;
+    cacheLists = 0;
+    cacheSavedBytes = 0;
+    culledBytes = 0;
+    mergedDraws = 0;
+
+    const uint fb_width = static_cast<uint>(draw_data->DisplaySize.x);
+    const uint fb_height = static_cast<uint>(draw_data->DisplaySize.y);
+
+    //list hashes, shared by the list cache and the frame fingerprint
+    if (listCaching() || retaining()) {
+        const auto t = clock();
+        const uint lists = static_cast<uint>(draw_data->CmdListsCount);
+        listHashes.resize(lists);
+        auto hash = [&](uint _n) {
+            listHashes[_n] = hashDrawList(draw_data->CmdLists[_n]);
+        };
+        const uint frameBytes = draw_data->TotalVtxCount * vertSize + draw_data->TotalIdxCount * (uint)sizeof(ImDrawIdx);
+        if (workers() && lists > 1 && frameBytes >= parallelThreshold)
+            workers()->run(lists, hash);
+        else
+            for (uint n = 0; n < lists; n++)
+                hash(n);
+        uploadTime += (clock() - t).count();
+    }
+
+    //retained frame. an unchanged fingerprint only composites the last frame
+    GLuint target = 0;
+    if (retaining()) {
+        target = state.drawFramebuffer();
+
+        uint64_t hash = hashBytes(listHashes.data(), listHashes.size() * sizeof(uint64_t), 0);
+        hash = hashBytes(&draw_data->DisplayPos, sizeof(ImVec2), hash);
+        hash = hashBytes(&draw_data->DisplaySize, sizeof(ImVec2), hash);
+        const bool resized = fb_width != frameWidth || fb_height != frameHeight;
+        const bool moved = draw_data->DisplayPos.x != frameOrigin.x || draw_data->DisplayPos.y != frameOrigin.y;
+        //callbacks draw what the draw data does not describe, such frames are always redrawn in full
+        bool callbacks = false;
+        for (int n = 0; n < draw_data->CmdListsCount && !callbacks; n++)
+            for (const ImDrawCmd& cmd : draw_data->CmdLists[n]->CmdBuffer)
+                callbacks |= cmd.UserCallback != nullptr && cmd.UserCallback != ImDrawCallback_ResetRenderState;
+        dirty = hash != frameHash || resized || callbacks;
+        frameHash = hash;
+        frameOrigin = draw_data->DisplayPos;
+
+        if (resized) {
+            frameWidth = fb_width;
+            frameHeight = fb_height;
+            state.forgetTexture(frameTex);
+            glDeleteTextures(1, &frameTex);
+            glGenTextures(1, &frameTex);
+            state.bindTexture(0, frameTex);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, std::max(1u, fb_width), std::max(1u, fb_height));
+            state.bindDrawFramebuffer(frameFBO);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, frameTex, 0);
+        }
+
+        damage.clear();
+        if (dirty && tracking()) {
+            trackDamage(draw_data, resized || moved || callbacks);
+            dirty = !damage.empty();
+        } else if (dirty)
+            damage.push_back(ImVec4(0.f, 0.f, (float)fb_width, (float)fb_height));
+
+        damageRects.clear();
+        damageArea = 0.f;
+        for (const ImVec4& d : damage) {
+            damageRects.push_back({ (int)d.x, (int)(fb_height - d.w), (int)(d.z - d.x), (int)(d.w - d.y) });
+            damageArea += (d.z - d.x) * (d.w - d.y);
+        }
+        damageArea /= std::max(1.f, (float)fb_width * (float)fb_height);
+
+        if (!dirty) {
+            composite(target, fb_width, fb_height);
+            finishFrame(saved, fb_width, fb_height);
+            updateDrawTime();
+            return;
+        }
+
+        //only the damaged rects are cleared, everything intersecting them is redrawn
+        state.bindDrawFramebuffer(frameFBO);
+        const GLfloat transparent[4] = { 0.f, 0.f, 0.f, 0.f };
+        state.enable(GL_SCISSOR_TEST, true);
+        for (const DamageRect& d : damageRects) {
+            state.scissor(d.x, d.y, d.width, d.height);
+            glClearBufferfv(GL_COLOR, 0, transparent);
+            ++state.calls;
+        }
+    } else {
+        damageRects.assign(1, { 0, 0, (int)fb_width, (int)fb_height });
+        damageArea = 1.f;
+    }
+
+    //redrawn commands are split per damage rect
+    const bool clipDamage = tracking();
+    const uint drawRects = clipDamage ? static_cast<uint>(damage.size()) : 1;
+
+    //grow the storage to the frame, within the limits. a single list always has to fit. the segments of split
+    //lists are only known after the list cache, which a grow empties. every run of quads adds at most two
+    //segments to its command, the triangles before it and the run itself
+    {
+        uint largestVert = 0, largestIdx = 0, needCmd = 0;
+        for (int n = 0; n < draw_data->CmdListsCount; n++) {
+            const ImDrawList* cmd_list = draw_data->CmdLists[n];
+            largestVert = std::max(largestVert, static_cast<uint>(cmd_list->VtxBuffer.Size));
+            largestIdx = std::max(largestIdx, static_cast<uint>(cmd_list->IdxBuffer.Size));
+            needCmd += static_cast<uint>(cmd_list->CmdBuffer.Size);
+            if (pullingQuads())
+                needCmd += 2 * (static_cast<uint>(cmd_list->IdxBuffer.Size) / (MinQuadRun * 6));
+        }
+        needCmd *= drawRects;
+        uint needVert = static_cast<uint>(draw_data->TotalVtxCount);
+        uint needIdx = static_cast<uint>(draw_data->TotalIdxCount);
+        if (vertLimit != 0) needVert = std::max(std::min(needVert, vertLimit), largestVert);
+        if (idxLimit != 0) needIdx = std::max(std::min(needIdx, idxLimit), largestIdx);
+        if (needVert > vertBound || needIdx > idxBound || needCmd > cmdBound) {
+            //double to keep the number of reallocations logarithmic
+            uint newVert = needVert > vertBound ? std::max(needVert, vertBound * 2) : vertBound;
+            uint newIdx = needIdx > idxBound ? std::max(needIdx, idxBound * 2) : idxBound;
+            if (vertLimit != 0) newVert = std::max(std::min(newVert, vertLimit), needVert);
+            if (idxLimit != 0) newIdx = std::max(std::min(newIdx, idxLimit), needIdx);
+            grow(newVert, newIdx, needCmd > cmdBound ? std::max(needCmd, cmdBound * 2) : cmdBound);
+        }
+    }
+
+    frameArena.reset();
+
+    DrawMode mode = activeDrawMode();
+    if (mode == DrawMode::IndirectDrawID && drawIdShader == 0)
+        mode = DrawMode::Indirect;
+    const GLuint program = mode == DrawMode::Direct ? shader : mode == DrawMode::Indirect ? indirectShader : drawIdShader;
+    //other GUIs of the renderer set the layer uniform of the shared program too
+    if (renderer)
+        directLayer = INT_MIN;
+
+    if (pullingQuads() && quadShader == 0) {
+        Programs own;
+        own.cache = programCache;
+        own.bindless = bindless;
+        Programs& p = renderer ? renderer->programs : own;
+        p.createQuads();
+        quadShader = p.quadShader;
+        quadIndirectShader = p.quadIndirect;
+        quadDrawIdShader = p.quadDrawId;
+    }
+    const bool quads = pullingQuads();
+    const GLuint quadProgram = mode == DrawMode::Direct ? quadShader : mode == DrawMode::Indirect ? quadIndirectShader : quadDrawIdShader;
+    pulledQuads = 0;
+    if (renderer)
+        quadLayer = INT_MIN;
+
+    const float L = draw_data->DisplayPos.x;
+    const float R = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
+    float T = draw_data->DisplayPos.y;
+    float B = draw_data->DisplayPos.y + draw_data->DisplaySize.y;
+    if (!lowerLeft())
+        std::swap(T, B);
+    //packed positions are in fixed point
+    const float S = packed() ? 1.f / PackedPosScale : 1.f;
+    const float ortho_projection[4][4] =
+    {
+        { 2.f * S / (R - L),    0.f,                0.0f,       0.0f },
+        { 0.f,                  2.f * S / (T - B),  0.0f,       0.0f },
+        { 0.f,                  0.f,                -1.0f,      0.0f },
+        { (R + L) / (L - R),    (T + B) / (B - T),  0.0f,       1.0f },
+    };
+    //pulled quads are always in fixed point
+    float quad_projection[4][4];
+    std::memcpy(quad_projection, ortho_projection, sizeof(quad_projection));
+    quad_projection[0][0] = 2.f / PackedPosScale / (R - L);
+    quad_projection[1][1] = 2.f / PackedPosScale / (T - B);
+
+    //font and GL textures are bound to unit 0, images of the array select their layer
+    GLuint boundTex = tex;
+
+    //everything the draws rely on. set once per frame and again after a user callback
+    const auto setupRenderState = [&]() {
+        if (retaining())
+            state.bindDrawFramebuffer(frameFBO);
+        state.enable(GL_BLEND, true);
+        state.blendEquation(GL_FUNC_ADD, GL_FUNC_ADD);
+        //the retained frame accumulates premultiplied alpha so it can be composited over anything
+        if (retaining())
+            state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        else
+            state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        state.enable(GL_CULL_FACE, false);
+        state.enable(GL_DEPTH_TEST, false);
+        state.polygonMode(GL_FILL);
+        state.enable(GL_SCISSOR_TEST, mode == DrawMode::Direct);
+
+        state.useProgram(program);
+        state.bindVertexArray(VAO);
+        if (mode != DrawMode::Direct)
+            state.bindIndirectBuffer(CBO);
+        if (mode == DrawMode::IndirectDrawID)
+            state.bindStorageBuffer(InfoBO);
+
+        state.viewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height);
+        if (imageArray != 0)
+            state.bindTexture(1, imageArray);
+        state.bindTexture(0, tex);
+        state.activeTexture(GL_TEXTURE0);
+        glUniformMatrix4fv(3, 1, GL_FALSE, &ortho_projection[0][0]);
+        ++state.calls;
+        if (quads) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, VBO);
+            glProgramUniformMatrix4fv(quadProgram, 3, 1, GL_FALSE, &quad_projection[0][0]);
+            state.calls += 2;
+        }
+        boundTex = tex;
+    };
+    setupRenderState();
+
+    //callbacks run in command order. a user callback may change any state, a plot only swaps program and
+    //vertex array
+    const auto runCallback = [&](uint _i) {
+        const ImDrawCmd* cmd = cmds.callback[_i];
+        if (cmd->UserCallback == plotCallback) {
+            drawPlot(cmd, clip_off, clip_scale, fb_width, fb_height);
+            state.useProgram(program);
+            state.bindVertexArray(VAO);
+            state.enable(GL_SCISSOR_TEST, mode == DrawMode::Direct);
+            return;
+        }
+        if (cmd->UserCallback != ImDrawCallback_ResetRenderState) {
+            cmd->UserCallback(cmds.parent[_i], cmd);
+            state.invalidate();
+        }
+        setupRenderState();
+    };
+
+    const auto decodeTexture = [&](ImTextureID _id, GLuint& _tex, GLint& _layer) {
+        const uintptr_t id = (uintptr_t)(intptr_t)_id;
+        _tex = boundTex;
+        _layer = -1;
+        if (id & ImageFlag)
+            _layer = static_cast<GLint>(id & ~ImageFlag);
+        else
+            _tex = id == 0 ? tex : static_cast<GLuint>(id);
+    };
+
+    //list cache. lists that kept their hash since the last frame move into the arena, resident lists skip the upload
+    listSlots.assign(draw_data->CmdListsCount, nullptr);
+    if (listCaching()) {
+        const auto t = clock();
+        const uint lists = static_cast<uint>(draw_data->CmdListsCount);
+        cacheLists = lists;
+        for (uint n = 0; n < lists; n++) {
+            const ImDrawList* cmd_list = draw_data->CmdLists[n];
+            const uint vtxCount = static_cast<uint>(cmd_list->VtxBuffer.Size);
+            const uint idxCount = static_cast<uint>(cmd_list->IdxBuffer.Size);
+            auto it = listCache.find(listKeys[n]);
+            if (it == listCache.end()) {
+                CachedList& e = listCache[listKeys[n]];
+                e.hash = listHashes[n];
+                e.lastSeen = frameSerial;
+                continue;
+            }
+            CachedList& e = it->second;
+            e.lastSeen = frameSerial;
+            if (e.hash != listHashes[n]) {
+                releaseCached(e);
+                e.hash = listHashes[n];
+                continue;
+            }
+            if (e.resident) {
+                ++cacheHits;
+                cacheSavedBytes += vtxCount * vertSize + idxCount * (uint)sizeof(ImDrawIdx);
+            } else if (vtxCount != 0) {
+                //promote. the block is free, no frame in flight reads it
+                if (!vtxArena.alloc(vtxCount, e.vtx)) continue;
+                if (!idxArena.alloc(idxCount, e.idx)) {
+                    vtxArena.release(e.vtx, vtxCount);
+                    continue;
+                }
+                e.vtxCount = vtxCount;
+                e.idxCount = idxCount;
+                e.resident = true;
+                copyList(vtxCapacity + e.vtx, idxCapacity + e.idx, cmd_list);
+                flushMapped(VBO, (vtxBase + vtxCapacity + e.vtx) * (size_t)vertSize, vtxCount * (size_t)vertSize);
+                flushMapped(EBO, (idxBase + idxCapacity + e.idx) * sizeof(ImDrawIdx), idxCount * sizeof(ImDrawIdx));
+                uploadBytes += vtxCount * vertSize + idxCount * (uint)sizeof(ImDrawIdx);
+            }
+            if (e.resident)
+                listSlots[n] = &e;
+        }
+
+        //lists that were not drawn this frame, e.g. closed windows
+        for (auto it = listCache.begin(); it != listCache.end();) {
+            if (it->second.lastSeen != frameSerial) {
+                releaseCached(it->second);
+                it = listCache.erase(it);
+            } else
+                ++it;
+        }
+        uploadTime += (clock() - t).count();
+    }
+
+    //uploaded lists with runs of quads are split into segments. a split list uploads the vertices of its runs of
+    //triangles plus its PackedQuads, which is what its chunk has to be sized by
+    listVerts.resize(draw_data->CmdListsCount);
+    listCmds.resize(draw_data->CmdListsCount);
+    if (quads) {
+        const auto t = clock();
+        if (listSegments.size() < listVerts.size())
+            listSegments.resize(listVerts.size());
+        auto scan = [&](uint _n) {
+            const ImDrawList* cmd_list = draw_data->CmdLists[_n];
+            const uint split = listSlots[_n] == nullptr ? scanQuads(cmd_list, listSegments[_n], clip_off, clip_scale, fb_width, fb_height) : 0;
+            if (split == 0)
+                listSegments[_n].clear();
+            listVerts[_n] = split != 0 ? split : static_cast<uint>(cmd_list->VtxBuffer.Size);
+            listCmds[_n] = split != 0 ? static_cast<uint>(listSegments[_n].size()) : static_cast<uint>(cmd_list->CmdBuffer.Size);
+        };
+        const uint lists = static_cast<uint>(draw_data->CmdListsCount);
+        const uint frameBytes = static_cast<uint>(draw_data->TotalVtxCount) * vertSize + static_cast<uint>(draw_data->TotalIdxCount) * (uint)sizeof(ImDrawIdx);
+        if (workers() && lists > 1 && frameBytes >= parallelThreshold)
+            workers()->run(lists, scan);
+        else
+            for (uint n = 0; n < lists; n++)
+                scan(n);
+        uploadTime += (clock() - t).count();
+    } else
+        for (int n = 0; n < draw_data->CmdListsCount; n++) {
+            listVerts[n] = static_cast<uint>(draw_data->CmdLists[n]->VtxBuffer.Size);
+            listCmds[n] = static_cast<uint>(draw_data->CmdLists[n]->CmdBuffer.Size);
+        }
+
+    //upload and draw the lists in chunks that fit the per-frame bound
+    for (int first = 0; first < draw_data->CmdListsCount;) {
 
-namespace TurboGUI {
+        int last = first;
+        uint chunkVert = 0, chunkIdx = 0, chunkCmd = 0;
+        while (last < draw_data->CmdListsCount) {
+            const ImDrawList* cmd_list = draw_data->CmdLists[last];
+            if (listSlots[last] == nullptr) {
+                if (chunkVert + listVerts[last] > vertBound || chunkIdx + cmd_list->IdxBuffer.Size > idxBound) break;
+                chunkVert += listVerts[last];
+                chunkIdx += cmd_list->IdxBuffer.Size;
+            }
+            chunkCmd += listCmds[last];
+            ++last;
+        }
 
-    typedef unsigned short ushort;
-    typedef unsigned int uint;
+        //pre-run. the prefix sum over the list sizes makes every list independent of the others
+        const auto t = clock();
+        const uint lists = static_cast<uint>(last - first);
+        listOffsets.resize(lists);
+        for (uint n = 0; n < lists; n++)
+            listOffsets[n].quads = quads && !listSegments[first + n].empty();
 
-	class TurboGuiException : public std::exception {
-		const std::string msg;
-	public:
-		TurboGuiException(std::string _msg) : msg(_msg) {};
-		virtual const char* what() const throw() {
-			return msg.c_str();
-		}
-	};
+        //the commands of the chunk, their scissor rects and visibility
+        uint cmd_offset = 0;
+        for (uint n = 0; n < lists; n++) {
+            listOffsets[n].cmd = cmd_offset;
+            cmd_offset += listCmds[first + n];
+        }
+        cmds.allocate(frameArena, cmd_offset);
+        const auto fill = [&](uint _i, const ImDrawList* _list, const ImDrawCmd& _cmd, uint _first, uint _count, bool _quads) {
+            cmds.clipX0[_i] = _cmd.ClipRect.x;
+            cmds.clipY0[_i] = _cmd.ClipRect.y;
+            cmds.clipX1[_i] = _cmd.ClipRect.z;
+            cmds.clipY1[_i] = _cmd.ClipRect.w;
+            cmds.elemCount[_i] = _count;
+            cmds.texture[_i] = _cmd.TextureId;
+            cmds.srcIdx[_i] = _list->IdxBuffer.Data + _cmd.IdxOffset + _first;
+            cmds.srcVtx[_i] = _list->VtxBuffer.Data + _cmd.VtxOffset;
+            cmds.callback[_i] = _cmd.UserCallback ? &_cmd : nullptr;
+            cmds.parent[_i] = _list;
+            cmds.quad[_i] = _quads;
+        };
+        for (uint n = 0; n < lists; n++) {
+            const ImDrawList* cmd_list = draw_data->CmdLists[first + n];
+            if (listOffsets[n].quads) {
+                const std::vector<Segment>& segments = listSegments[first + n];
+                for (uint k = 0; k < segments.size(); k++) {
+                    const Segment& g = segments[k];
+                    fill(listOffsets[n].cmd + k, cmd_list, cmd_list->CmdBuffer[g.cmd], g.first, g.count, g.quads);
+                }
+            } else
+                for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
+                    const ImDrawCmd& cmd = cmd_list->CmdBuffer[cmd_i];
+                    fill(listOffsets[n].cmd + cmd_i, cmd_list, cmd, 0, cmd.ElemCount, false);
+                }
+        }
+        clipCommands(cmds, clip_off, clip_scale, fb_width, fb_height);
 
-	class GUI {
+        //culling. uploaded lists only copy the indices of visible commands, a list without any skips its vertices too
+        uint uploadVert = 0, uploadIdx = 0;
+        for (uint n = 0; n < lists; n++) {
+            const ImDrawList* cmd_list = draw_data->CmdLists[first + n];
+            ListOffset& o = listOffsets[n];
+            o.idxCount = static_cast<uint>(cmd_list->IdxBuffer.Size);
+            o.vtxCount = 0;
+            if (listSlots[first + n]) continue;
+            if (o.quads) {
+                //split lists always cull, the vertices of every run are counted on their own. never more than
+                //scanQuads() counted, the commands it skipped stay culled
+                const std::vector<Segment>& segments = listSegments[first + n];
+                uint idxCount = 0, vtxCount = 0, quadCount = 0;
+                for (uint k = 0; k < segments.size(); k++) {
+                    const uint i = o.cmd + k;
+                    if (!cmds.visible[i] || cmds.elemCount[i] == 0 || (!segments[k].quads && segments[k].vtxMin > segments[k].vtxMax)) {
+                        cmds.visible[i] = 0;
+                        culledBytes += cmds.elemCount[i] * (uint)sizeof(ImDrawIdx);
+                    } else if (segments[k].quads)
+                        quadCount += cmds.elemCount[i] / 6;
+                    else {
+                        idxCount += cmds.elemCount[i];
+                        vtxCount += segments[k].vtxMax - segments[k].vtxMin + 1;
+                    }
+                }
+                o.idxCount = idxCount;
+                o.vtxCount = vtxCount + quadSlots(quadCount);
+                pulledQuads += quadCount;
+                uploadVert += o.vtxCount;
+                uploadIdx += o.idxCount;
+                continue;
+            }
+            if (commandCulling) {
+                uint visibleIdx = 0;
+                for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
+                    const uint i = o.cmd + cmd_i;
+                    if (cmds.visible[i] && cmds.elemCount[i] != 0)
+                        visibleIdx += cmds.elemCount[i];
+                    else
+                        cmds.visible[i] = 0;
+                }
+                culledBytes += (o.idxCount - visibleIdx) * (uint)sizeof(ImDrawIdx);
+                o.idxCount = visibleIdx;
+                if (visibleIdx == 0)
+                    culledBytes += cmd_list->VtxBuffer.Size * vertSize;
+            }
+            if (o.idxCount != 0)
+                o.vtxCount = static_cast<uint>(cmd_list->VtxBuffer.Size);
+            uploadVert += o.vtxCount;
+            uploadIdx += o.idxCount;
+        }
 
-		GLuint VAO[2], VBO[2], EBO[2];
-		GLuint tex;
-		GLuint shader;
+        //the previous chunk gets its own fence so the ring can wrap into it
+        if (submits != 0)
+            closeRegion(false);
+        reserve(uploadVert, uploadIdx, mode == DrawMode::Direct ? 0 : chunkCmd * drawRects);
+        ++submits;
 
-		float* VBO_ptr[2];
-		ushort* EBO_ptr[2];
+        {
+            uint v_offset = pending.vtxBegin;
+            uint idx_offset = pending.idxBegin;
+            for (uint n = 0; n < lists; n++) {
+                const ImDrawList* cmd_list = draw_data->CmdLists[first + n];
+                const CachedList* cached = listSlots[first + n];
+                ListOffset& o = listOffsets[n];
+                if (cached) {
+                    o.vtx = vtxCapacity + cached->vtx;
+                    o.idx = idxCapacity + cached->idx;
+                    o.upload = false;
+                    vert += cmd_list->VtxBuffer.Size;
+                    idx += cmd_list->IdxBuffer.Size;
+                } else {
+                    o.vtx = v_offset;
+                    o.idx = idx_offset;
+                    o.upload = o.vtxCount != 0;
+                    v_offset += o.vtxCount;
+                    idx_offset += o.idxCount;
+                }
+            }
 
-		GLsync syncObj[2];
+            auto upload = [&](uint _n) {
+                const ImDrawList* cmd_list = draw_data->CmdLists[first + _n];
+                const ListOffset& o = listOffsets[_n];
+                if (o.quads) {
+                    //runs of triangles go out with the vertices they reference, the quads follow them
+                    const std::vector<Segment>& segments = listSegments[first + _n];
+                    uint v = o.vtx, dst = o.idx;
+                    for (uint k = 0; k < segments.size(); k++) {
+                        const Segment& g = segments[k];
+                        const uint i = o.cmd + k;
+                        if (!cmds.visible[i] || g.quads) continue;
+                        const uint count = g.vtxMax - g.vtxMin + 1;
+                        copyVertices(v, cmds.srcVtx[i] + g.vtxMin, count);
+                        copyIndices(dst, cmds.srcIdx[i], cmds.elemCount[i]);
+                        cmds.baseVertex[i] = (GLint)v - (GLint)g.vtxMin;
+                        cmds.firstIndex[i] = dst;
+                        v += count;
+                        dst += cmds.elemCount[i];
+                    }
+                    //the vertex shader indexes whole PackedQuads in the buffer
+                    uint slot = static_cast<uint>(((vtxBase + v) * (size_t)vertSize + sizeof(PackedQuad) - 1) / sizeof(PackedQuad));
+                    PackedQuad* out = reinterpret_cast<PackedQuad*>(VBO_ptr + slot * sizeof(PackedQuad) - vtxBase * (size_t)vertSize);
+                    for (uint k = 0; k < segments.size(); k++) {
+                        const uint i = o.cmd + k;
+                        if (!cmds.visible[i] || !segments[k].quads) continue;
+                        const uint count = cmds.elemCount[i] / 6;
+                        packQuads(out, cmds.srcIdx[i], cmds.srcVtx[i], count);
+                        cmds.baseVertex[i] = 0;
+                        cmds.firstIndex[i] = slot * 6;
+                        out += count;
+                        slot += count;
+                    }
+                    return;
+                }
+                const bool compact = o.upload && commandCulling;
+                if (o.upload) {
+                    copyVertices(o.vtx, cmd_list);
+                    if (!compact)
+                        copyIndices(o.idx, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size);
+                }
+                //runs of visible commands are contiguous in the list and go out in one copy
+                uint dst = o.idx, runBegin = 0, runCount = 0;
+                for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
+                    const ImDrawCmd& cmd = cmd_list->CmdBuffer[cmd_i];
+                    const uint i = o.cmd + cmd_i;
+                    cmds.baseVertex[i] = (GLint)(o.vtx + cmd.VtxOffset);
+                    if (!compact) {
+                        cmds.firstIndex[i] = o.idx + cmd.IdxOffset;
+                        continue;
+                    }
+                    if (!cmds.visible[i]) continue;
+                    if (runBegin + runCount != cmd.IdxOffset) {
+                        copyIndices(dst, cmd_list->IdxBuffer.Data + runBegin, runCount);
+                        dst += runCount;
+                        runBegin = cmd.IdxOffset;
+                        runCount = 0;
+                    }
+                    cmds.firstIndex[i] = dst + runCount;
+                    runCount += cmd.ElemCount;
+                }
+                if (compact)
+                    copyIndices(dst, cmd_list->IdxBuffer.Data + runBegin, runCount);
+            };
 
-		uint currIndex = 0;
+            //the buffers are persistently mapped, so any thread may write them
+            const uint chunkBytes = uploadVert * vertSize + uploadIdx * (uint)sizeof(ImDrawIdx);
+            if (workers() && lists > 1 && chunkBytes >= parallelThreshold)
+                workers()->run(lists, upload);
+            else
+                for (uint n = 0; n < lists; n++)
+                    upload(n);
 
-		std::chrono::high_resolution_clock::time_point time;
-		float drawTime = 0.f; //ms
-		std::vector<float> drawTimeMean = std::vector<float>(100);
-		uint drawMeanTimeIndex = 0;
-		float meanTime = 0.f;
+            flushMapped(VBO, (vtxBase + pending.vtxBegin) * (size_t)vertSize, uploadVert * (size_t)vertSize);
+            flushMapped(EBO, (idxBase + pending.idxBegin) * sizeof(ImDrawIdx), uploadIdx * sizeof(ImDrawIdx));
 
-		uint idxBound, vertBound;
-		uint maxIdx = 0, maxVert = 0;
-		uint idx, vert;
-		uint maxFps = 0;
-		uint timeOutSync = static_cast<uint>(5e6);
-		uint syncTime = 0;
+            //the bounds test only pays off where a merge saves a draw call
+            if (commandCulling)
+                mergeCommands(mode == DrawMode::Direct, clip_off, clip_scale, fb_width, fb_height);
 
-		ImGuiContext* context;
+            idx += uploadIdx;
+            vert += uploadVert;
+            uploadBytes += chunkBytes;
+            uploadTime += (clock() - t).count();
+        }
 
-	public:
-		GUI() { context = ImGui::CreateContext(); }
-		~GUI();
-		void initGL(uint, uint);
-		/* use ImGui::GetIO() to set up mouse and keyboard inputs before calling this */
-		void begin();
-		void draw();
-		void sync();
+        //draw
+        if (mode != DrawMode::Direct) {
+            DrawElementsIndirectCommand* records = CBO_ptr + pending.cmdBegin;
+            DrawInfo* infos = Info_ptr + pending.cmdBegin;
+            uint count = 0;
+            recordTextures.resize(cmds.size * drawRects);
+            recordQuads.resize(cmds.size * drawRects);
+            callbackPoints.clear();
+            for (uint i = 0; i < cmds.size; ++i) {
+                if (cmds.callback[i]) {
+                    callbackPoints.push_back({ count, i });
+                    continue;
+                }
+                if (cmds.elemCount[i] == 0 || !cmds.visible[i]) continue;
 
-		//draws a window with stats
-		void drawStatsWindow(uint = 0);
-		//inserts the stats in an already existing window
-		void drawStats();
+                GLuint cmdTex;
+                GLint layer;
+                decodeTexture(cmds.texture[i], cmdTex, layer);
+                const ImVec2 uvScale = layer < 0 ? ImVec2(1.f, 1.f) : imageScales[layer];
+                const GLuint64 handle = bindless && layer < 0 ? textureHandle(cmdTex) : 0;
 
-		//sets the timeout for the syncinc process in ns. setting it too low at own perill. 
-		void setSyncTimeOut(uint _time) {
-			timeOutSync = _time;
-		}
+                //same integer rect glScissor would get, as [min, max) in window coordinates
+                for (uint r = 0; r < drawRects; ++r) {
+                    int x0 = cmds.x[i], y0 = cmds.y[i];
+                    int x1 = x0 + cmds.width[i], y1 = y0 + cmds.height[i];
+                    if (clipDamage) {
+                        const DamageRect& d = damageRects[r];
+                        x0 = std::max(x0, d.x);
+                        y0 = std::max(y0, d.y);
+                        x1 = std::min(x1, d.x + d.width);
+                        y1 = std::min(y1, d.y + d.height);
+                        if (x0 >= x1 || y0 >= y1) continue;
+                    }
+                    DrawInfo& info = infos[count];
+                    info.clip = ImVec4((float)x0, (float)y0, (float)x1, (float)y1);
+                    info.uvScale[0] = uvScale.x;
+                    info.uvScale[1] = uvScale.y;
+                    info.layer = layer;
+                    info.handle = handle;
+                    recordTextures[count] = cmdTex;
+                    recordQuads[count] = cmds.quad[i];
+                    records[count].count = cmds.elemCount[i];
+                    records[count].instanceCount = 1;
+                    if (cmds.quad[i]) {
+                        //DrawArraysIndirectCommand in the same stride, first and baseInstance move up
+                        records[count].firstIndex = cmds.firstIndex[i];
+                        records[count].baseVertex = (GLint)(pending.cmdBegin + count);
+                        records[count].baseInstance = 0;
+                    } else {
+                        records[count].firstIndex = idxBase + cmds.firstIndex[i];
+                        records[count].baseVertex = cmds.baseVertex[i];
+                        records[count].baseInstance = pending.cmdBegin + count;
+                    }
+                    ++count;
+                }
+            }
+            flushMapped(CBO, pending.cmdBegin * sizeof(DrawElementsIndirectCommand), count * sizeof(DrawElementsIndirectCommand));
+            flushMapped(InfoBO, pending.cmdBegin * sizeof(DrawInfo), count * sizeof(DrawInfo));
 
-		uint getIdxCount() { return idx; }
-		uint getVertCount() { return vert; }
-		uint getSyncTime() { return syncTime; }
-		float getDrawTime() { return drawTime; }
-		float getMeanDrawTime() { return meanTime; }
+            //one multi draw per run of records on the same texture, a single one with bindless handles. callbacks
+            //end a run
+            uint nextCallback = 0;
+            const auto runCallbacks = [&](uint _record) {
+                while (nextCallback < callbackPoints.size() && callbackPoints[nextCallback].record == _record)
+                    runCallback(callbackPoints[nextCallback++].cmd);
+            };
+            runCallbacks(0);
+            for (uint begin = 0; begin < count;) {
+                const uint limit = nextCallback < callbackPoints.size() ? callbackPoints[nextCallback].record : count;
+                uint end = begin + 1;
+                while (end < limit && (bindless || recordTextures[end] == recordTextures[begin]) && recordQuads[end] == recordQuads[begin])
+                    ++end;
+                if (!bindless && recordTextures[begin] != boundTex) {
+                    boundTex = recordTextures[begin];
+                    state.bindTexture(0, boundTex);
+                }
+                if (quads)
+                    state.useProgram(recordQuads[begin] ? quadProgram : program);
+                if (mode == DrawMode::IndirectDrawID) {
+                    glUniform1i(5, (GLint)(pending.cmdBegin + begin));
+                    ++state.calls;
+                }
+                const void* offset = (void*)(intptr_t)((pending.cmdBegin + begin) * sizeof(DrawElementsIndirectCommand));
+                if (recordQuads[begin])
+                    glMultiDrawArraysIndirect(GL_TRIANGLES, offset, (GLsizei)(end - begin), sizeof(DrawElementsIndirectCommand));
+                else
+                    glMultiDrawElementsIndirect(GL_TRIANGLES, IdxType, offset, (GLsizei)(end - begin), 0);
+                ++drawCalls;
+                begin = end;
+                runCallbacks(end);
+            }
+        } else for (uint i = 0; i < cmds.size; ++i) {
+            if (cmds.callback[i]) {
+                runCallback(i);
+                continue;
+            }
+            if (!cmds.visible[i]) continue;
 
-		ImGuiContext* getContext() { return context; }
-	};
+            GLuint cmdTex;
+            GLint layer;
+            decodeTexture(cmds.texture[i], cmdTex, layer);
+            if (cmdTex != boundTex) {
+                boundTex = cmdTex;
+                state.bindTexture(0, boundTex);
+            }
+            if (quads)
+                state.useProgram(cmds.quad[i] ? quadProgram : program);
+            //each program keeps its own layer uniform
+            GLint& programLayer = cmds.quad[i] ? quadLayer : directLayer;
+            if (layer != programLayer) {
+                const ImVec2 uvScale = layer < 0 ? ImVec2(1.f, 1.f) : imageScales[layer];
+                programLayer = layer;
+                glUniform1i(7, layer);
+                glUniform2f(8, uvScale.x, uvScale.y);
+                state.calls += 2;
+            }
+
+            for (uint r = 0; r < drawRects; ++r) {
+                int x = cmds.x[i], y = cmds.y[i];
+                int w = cmds.width[i], h = cmds.height[i];
+                if (clipDamage) {
+                    const DamageRect& d = damageRects[r];
+                    const int x0 = std::max(x, d.x), y0 = std::max(y, d.y);
+                    w = std::min(x + w, d.x + d.width) - x0;
+                    h = std::min(y + h, d.y + d.height) - y0;
+                    x = x0;
+                    y = y0;
+                    if (w <= 0 || h <= 0) continue;
+                }
+                state.scissor(x, y, w, h);
+                if (cmds.quad[i])
+                    glDrawArrays(GL_TRIANGLES, (GLint)cmds.firstIndex[i], (GLsizei)cmds.elemCount[i]);
+                else
+                    glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)cmds.elemCount[i], IdxType, (void*)(intptr_t)((idxBase + cmds.firstIndex[i]) * sizeof(ImDrawIdx)), cmds.baseVertex[i]);
+                ++drawCalls;
+            }
+        }
+
+        first = last;
+    }
+
+    maxIdx = std::max(idx, maxIdx);
+    maxVert = std::max(vert, maxVert);
+
+    if (retaining())
+        composite(target, fb_width, fb_height);
 
+    finishFrame(saved, fb_width, fb_height);
+    updateDrawTime();
 }
 
-inline TurboGUI::GUI::~GUI() {
-    glDeleteVertexArrays(2, VAO);
-    glDeleteBuffers(2, VBO);
-    glDeleteBuffers(2, EBO);
-    glDeleteProgram(shader);
-    glDeleteTextures(1, &tex);
-    glDeleteSync(syncObj[0]);
-    glDeleteSync(syncObj[1]);
+template<class Config>
+inline void TurboGUI::GUI<Config>::finishFrame(const GLStateCache::State& _saved, uint _width, uint _height) {
+    if (restoreState)
+        state.restore(_saved);
+    else {
+        //leave the context as clean as the host can expect it without restore. the bindings stay when the
+        //state is persistent, the scissor covers the screen either way so host clears are not clipped
+        if (!persistentState) {
+            state.bindTexture(1, 0);
+            state.bindTexture(0, 0);
+            state.bindVertexArray(0);
+            state.useProgram(0);
+            state.bindIndirectBuffer(0);
+            state.bindStorageBuffer(0);
+            state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        state.enable(GL_SCISSOR_TEST, true);
+        state.scissor(0, 0, (GLsizei)_width, (GLsizei)_height);
+    }
+    endGpuTimer();
+    textureBinds = state.textureBinds;
+    glCalls = state.calls + drawCalls;
 }
 
-inline void TurboGUI::GUI::initGL(uint _vbo_upper_bound, uint _ebo_upper_bound) {
- 
-    std::memset(drawTimeMean.data(), 0, drawTimeMean.size() * sizeof(float));
+template<class Config>
+inline void TurboGUI::GUI<Config>::setGpuTiming(bool _timing) {
+    static_assert(Config::Stats, "gpu timing needs a config with Stats");
+    gpuTiming = _timing;
+    if (_timing && gpuTimers[0].queries[0] == 0)
+        for (GpuTimer& t : gpuTimers)
+            glGenQueries(2, t.queries);
+}
 
-    {
-        ImGuiIO& io = ImGui::GetIO();
-        unsigned char* pixels;
-        int width, height;
-        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+template<class Config>
+inline void TurboGUI::GUI<Config>::beginGpuTimer() {
+    gpuTimerActive = Config::Stats && gpuTiming && !gpuTimers[gpuTimerHead].pending;
+    if (!gpuTimerActive) return;
+    glQueryCounter(gpuTimers[gpuTimerHead].queries[0], GL_TIMESTAMP);
+    gpuTimers[gpuTimerHead].frame = frameSerial;
+    ++state.calls;
+}
 
-        glGenTextures(1, &tex);
-        glBindTexture(GL_TEXTURE_2D, tex);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+template<class Config>
+inline void TurboGUI::GUI<Config>::endGpuTimer() {
+    if (!gpuTimerActive) return;
+    glQueryCounter(gpuTimers[gpuTimerHead].queries[1], GL_TIMESTAMP);
+    ++state.calls;
+    gpuTimers[gpuTimerHead].pending = true;
+    gpuTimerHead = (gpuTimerHead + 1) % (MaxFramesInFlight + 1);
+    gpuTimerActive = false;
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::readGpuTimers() {
+    //oldest first, stops at the first frame the gpu did not finish yet
+    while (gpuTimers[gpuTimerTail].pending) {
+        GpuTimer& t = gpuTimers[gpuTimerTail];
+        GLint available = 0;
+        glGetQueryObjectiv(t.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(t.queries[0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(t.queries[1], GL_QUERY_RESULT, &end);
+        gpuTime = static_cast<float>(end - begin) * 1e-6f;
+        t.pending = false;
+        //the frame may still be in the trace ring
+        if (!traceFrames.empty()) {
+            FrameRecord& r = traceFrames[t.frame % traceFrames.size()];
+            if (r.frame == t.frame)
+                r.gpu = gpuTime;
+        }
+        gpuTimerTail = (gpuTimerTail + 1) % (MaxFramesInFlight + 1);
     }
+}
 
-    idxBound = _ebo_upper_bound;
-    vertBound = _vbo_upper_bound;
+template<class Config>
+inline void TurboGUI::GUI<Config>::setImageArray(uint _width, uint _height, uint _layers) {
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (_layers == 0 || _layers > static_cast<uint>(maxLayers))
+        throw TurboGuiException("image array needs between 1 and " + std::to_string(maxLayers) + " layers");
 
-    //map buffers
-    glGenVertexArrays(2, VAO);
+    //frames in flight may still sample the old array, GL keeps it alive until they are done
+    state.forgetTexture(imageArray);
+    glDeleteTextures(1, &imageArray);
+    glGenTextures(1, &imageArray);
+    state.bindTexture(1, imageArray);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, _width, _height, _layers);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    state.bindTexture(1, 0);
+    state.activeTexture(GL_TEXTURE0);
+
+    imageWidth = _width;
+    imageHeight = _height;
+    imageLayers = _layers;
+    imageScales.clear();
+}
 
-    glGenBuffers(2, VBO);
-    glGenBuffers(2, EBO);
+template<class Config>
+inline ImTextureID TurboGUI::GUI<Config>::addImage(const void* _rgba, uint _width, uint _height) {
+    if (imageArray == 0)
+        throw TurboGuiException("no image array, call setImageArray first");
+    if (imageScales.size() == imageLayers)
+        throw TurboGuiException("image array is full");
+    if (_width > imageWidth || _height > imageHeight)
+        throw TurboGuiException("image does not fit into a layer of the image array");
 
-    for (uint i = 0; i < 2; ++i) {
-        glBindVertexArray(VAO[i]);
+    const uint layer = static_cast<uint>(imageScales.size());
+    state.bindTexture(1, imageArray);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, _width, _height, 1, GL_RGBA, GL_UNSIGNED_BYTE, _rgba);
+    state.bindTexture(1, 0);
+    state.activeTexture(GL_TEXTURE0);
+    imageScales.push_back(ImVec2(static_cast<float>(_width) / imageWidth, static_cast<float>(_height) / imageHeight));
+    return (ImTextureID)(intptr_t)(ImageFlag | layer);
+}
 
-        //vbo
-        glBindBuffer(GL_ARRAY_BUFFER, VBO[i]);
-        glBufferStorage(GL_ARRAY_BUFFER, _vbo_upper_bound * (uint)sizeof(ImDrawVert), nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_CLIENT_STORAGE_BIT);
-        VBO_ptr[i] = reinterpret_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, _vbo_upper_bound * (uint)sizeof(ImDrawVert), GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+template<class Config>
+inline void TurboGUI::GUI<Config>::updateFont(uint _x, uint _y, uint _width, uint _height) {
+    if (renderer)
+        throw TurboGuiException("the font texture belongs to the Renderer and is shared with other GUIs");
 
-        //pos
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, pos));
-        glEnableVertexAttribArray(0);
+    ImGui::SetCurrentContext(context);
+    ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+    unsigned char* pixels;
+    int width, height;
+    atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+    const bool rgba = atlas->TexPixelsUseColors;
+    if (rgba)
+        atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
 
-        //uv
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, uv));
-        glEnableVertexAttribArray(1);
+    //the glyphs changed under unchanged draw data
+    frameHash = 0;
+    damageLists.clear();
 
-        //col
-        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, col));
-        glEnableVertexAttribArray(2);
+    if (width != fontWidth || height != fontHeight || rgba != fontRGBA) {
+        //bindless textures are immutable, a new size needs a new texture
+        auto it = textureHandles.find(tex);
+        if (it != textureHandles.end()) {
+            glMakeTextureHandleNonResidentARB(it->second);
+            textureHandles.erase(it);
+        }
+        state.forgetTexture(tex);
+        glDeleteTextures(1, &tex);
+        tex = createFontTexture({ pixels, width, height, rgba, false });
+        atlas->SetTexID((ImTextureID)(intptr_t)tex);
+        fontWidth = width;
+        fontHeight = height;
+        fontRGBA = rgba;
+        state.invalidate();
+        return;
+    }
 
-        //ebo
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO[i]);
-        glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, _ebo_upper_bound * (uint)sizeof(ImDrawIdx), nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_CLIENT_STORAGE_BIT);
-        EBO_ptr[i] = reinterpret_cast<ushort*>(glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, _ebo_upper_bound * (uint)sizeof(ImDrawIdx), GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    if (_width == 0 || _height == 0) {
+        _x = 0;
+        _y = 0;
+        _width = width;
+        _height = height;
+    }
+    if (_x + _width > (uint)width || _y + _height > (uint)height)
+        throw TurboGuiException("rect is outside the font atlas");
 
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }   
+    //the rect is packed into the pbo, invalidating orphans the storage an earlier update may still read
+    const size_t bpp = rgba ? 4 : 1;
+    const size_t row = _width * bpp;
+    if (fontPBO == 0)
+        glGenBuffers(1, &fontPBO);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, fontPBO);
+    if (row * _height > fontPBOSize) {
+        fontPBOSize = row * _height;
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)fontPBOSize, nullptr, GL_STREAM_DRAW);
+    }
+    unsigned char* dst = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)(row * _height), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (!dst) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        throw TurboGuiException("failed to map the font upload buffer");
+    }
+    for (uint y = 0; y < _height; ++y)
+        std::memcpy(dst + y * row, pixels + ((size_t)(_y + y) * width + _x) * bpp, row);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
 
+    state.bindTexture(0, tex);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (GLint)_x, (GLint)_y, (GLsizei)_width, (GLsizei)_height, rgba ? GL_RGBA : GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    state.bindTexture(0, 0);
+}
+
+template<class Config>
+inline uint TurboGUI::GUI<Config>::createPlot(uint _capacity) {
+    if (VAO == 0)
+        throw TurboGuiException("createPlot needs initGL");
+    if (_capacity < 2)
+        throw TurboGuiException("a plot needs room for at least 2 samples");
+
+    if (plotShader == 0) {
+        Programs own;
+        own.cache = programCache;
+        Programs& p = renderer ? renderer->programs : own;
+        p.createPlot();
+        plotShader = p.plot;
+        decimateShader = p.decimate;
+        //the plot shaders fetch nothing but the samples
+        glGenVertexArrays(1, &plotVAO);
+    }
+
+    std::unique_ptr<Plot> plot(new Plot());
+    plot->capacity = _capacity;
+    plot->slots = _capacity * 2;
+    //coherent, pushPlot() writes from any thread without a gl call
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &plot->samples);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, plot->samples);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, plot->slots * (GLsizeiptr)sizeof(float), nullptr, flags);
+    plot->ptr = reinterpret_cast<float*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, plot->slots * (GLsizeiptr)sizeof(float), flags));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (!plot->ptr) {
+        glDeleteBuffers(1, &plot->samples);
+        throw TurboGuiException("failed to map the plot samples");
+    }
+    plots.push_back(std::move(plot));
+    return static_cast<uint>(plots.size() - 1);
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::pushPlot(uint _plot, const float* _samples, uint _count) {
+    Plot& p = *plots.at(_plot);
+    //only the newest capacity samples can ever be drawn
+    if (_count > p.capacity) {
+        p.dropped.fetch_add(_count - p.capacity, std::memory_order_relaxed);
+        _samples += _count - p.capacity;
+        _count = p.capacity;
+    }
+    //the slot of sample i held sample i - slots, which no capture below the floor reads anymore
+    uint64_t head = p.reserved.load(std::memory_order_relaxed);
+    uint count;
+    do {
+        const uint64_t limit = p.floor.load(std::memory_order_acquire) + p.slots;
+        count = head >= limit ? 0 : static_cast<uint>(std::min<uint64_t>(_count, limit - head));
+        if (count == 0) break;
+    } while (!p.reserved.compare_exchange_weak(head, head + count, std::memory_order_relaxed));
+    if (count != _count)
+        p.dropped.fetch_add(_count - count, std::memory_order_relaxed);
+    if (count == 0) return;
+
+    const uint at = static_cast<uint>(head % p.slots);
+    const uint first = std::min(count, p.slots - at);
+    std::memcpy(p.ptr + at, _samples, first * sizeof(float));
+    std::memcpy(p.ptr, _samples + first, (count - first) * sizeof(float));
+    //a plot() sees a gap free history, earlier reservations publish first
+    while (p.pushed.load(std::memory_order_acquire) != head)
+        std::this_thread::yield();
+    p.pushed.store(head + count, std::memory_order_release);
+    plotBytes.fetch_add(count * (uint)sizeof(float), std::memory_order_relaxed);
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::plot(uint _plot, const ImVec2& _size, float _min, float _max, uint _count, PlotMode _mode, ImU32 _color) {
+    Plot& p = *plots.at(_plot);
+    PlotView v;
+    v.min = ImGui::GetCursorScreenPos();
+    v.max = ImVec2(v.min.x + _size.x, v.min.y + _size.y);
+    v.lo = _min;
+    v.hi = _max;
+    v.color = _color != 0 ? _color : ImGui::GetColorU32(_mode == PlotMode::Lines ? ImGuiCol_PlotLines : ImGuiCol_PlotHistogram);
+    v.mode = _mode;
+    PlotCapture* capture;
     {
-        const GLchar* vertex_shader =
-            "#version 430 core\n"
-            "layout (location = 0) in vec2 Position;\n"
-            "layout (location = 1) in vec2 UV;\n"
-            "layout (location = 2) in vec4 Color;\n"
-            "layout (location = 3) uniform mat4 ProjMtx;\n"
-            "out vec2 Frag_UV;\n"
-            "out vec4 Frag_Color;\n"
-            "void main()\n"
-            "{\n"
-            "    Frag_UV = UV;\n"
-            "    Frag_Color = Color;\n"
-            "    gl_Position = ProjMtx * vec4(Position.xy,0.f,1.f);\n"
-            "}\n";
+        //read under the lock, retirePlots() then either sees the capture or a later end
+        std::lock_guard<std::mutex> lock(p.lock);
+        const uint64_t pushed = p.pushed.load(std::memory_order_acquire);
+        v.end = pushed;
+        v.count = static_cast<uint>(std::min<uint64_t>(_count == 0 ? p.capacity : std::min(_count, p.capacity), pushed));
+        p.captures.push_back({ &p, v, NotDrawn });
+        capture = &p.captures.back();
+    }
 
-        const GLchar* fragment_shader =
-            "#version 430 core\n"
-            "in vec2 Frag_UV;\n"
-            "in vec4 Frag_Color;\n"
-            "layout (location = 4) uniform sampler2D Texture;\n"
-            "out vec4 Out_Color;\n"
-            "void main()\n"
-            "{\n"
-            "    Out_Color = Frag_Color * texture(Texture, Frag_UV.xy);\n"
-            "}\n";
+    ImDrawList* list = ImGui::GetWindowDrawList();
+    list->AddRectFilled(v.min, v.max, ImGui::GetColorU32(ImGuiCol_FrameBg));
+    list->AddCallback(plotCallback, capture);
+    ImGui::Dummy(_size);
+}
 
-        //Compile Vertex
-        GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vertex_shader, nullptr);
-        glCompileShader(vertex);
-        GLint isCompiled = 0;
-        glGetShaderiv(vertex, GL_COMPILE_STATUS, &isCompiled);
-        if (isCompiled == GL_FALSE) {
-            GLint maxLength = 0;
-            glGetShaderiv(vertex, GL_INFO_LOG_LENGTH, &maxLength);
-            std::vector<GLchar> errorLog(maxLength);
-            glGetShaderInfoLog(vertex, maxLength, &maxLength, &errorLog[0]);
-            glDeleteShader(vertex);
-            throw TurboGuiException(std::string(errorLog.data()));
-        }
-
-        //Compile Frag
-        GLuint frag = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(frag, 1, &fragment_shader, nullptr);
-        glCompileShader(frag);
-        isCompiled = 0;
-        glGetShaderiv(frag, GL_COMPILE_STATUS, &isCompiled);
-        if (isCompiled == GL_FALSE) {
-            GLint maxLength = 0;
-            glGetShaderiv(frag, GL_INFO_LOG_LENGTH, &maxLength);
-            std::vector<GLchar> errorLog(maxLength);
-            glGetShaderInfoLog(frag, maxLength, &maxLength, &errorLog[0]);
-            glDeleteShader(frag);
-            throw TurboGuiException(std::string(errorLog.data()));
+template<class Config>
+inline void TurboGUI::GUI<Config>::drawPlot(const ImDrawCmd* _cmd, ImVec2 _offset, ImVec2 _scale, uint _width, uint _height) {
+    PlotCapture& c = *static_cast<PlotCapture*>(_cmd->UserCallbackData);
+    Plot& p = *c.plot;
+    {
+        std::lock_guard<std::mutex> lock(p.lock);
+        c.serial = frameSerial;
+    }
+    const PlotView v = c.view;
+    if (v.count < 2 || !(v.hi > v.lo)) return;
+
+    //the clip rect of the command, as the scissor of a draw
+    const float fbw = static_cast<float>(_width), fbh = static_cast<float>(_height);
+    const float cx0 = std::max((_cmd->ClipRect.x - _offset.x) * _scale.x, 0.f);
+    const float cy0 = std::max((_cmd->ClipRect.y - _offset.y) * _scale.y, 0.f);
+    const float cx1 = std::min((_cmd->ClipRect.z - _offset.x) * _scale.x, fbw);
+    const float cy1 = std::min((_cmd->ClipRect.w - _offset.y) * _scale.y, fbh);
+    if (cx0 >= cx1 || cy0 >= cy1) return;
+
+    //item rect in ndc, the bottom of the range at y0
+    const float x0 = (v.min.x - _offset.x) * _scale.x, x1 = (v.max.x - _offset.x) * _scale.x;
+    float y0 = 1.f - 2.f * (v.max.y - _offset.y) * _scale.y / fbh;
+    float y1 = 1.f - 2.f * (v.min.y - _offset.y) * _scale.y / fbh;
+    if (!lowerLeft()) {
+        y0 = -y0;
+        y1 = -y1;
+    }
+
+    //the ring holds the newest sample at end - 1
+    const uint start = static_cast<uint>((v.end - v.count) % p.slots);
+    const uint columns = std::max(1u, static_cast<uint>(x1 - x0));
+    GLuint source = p.samples;
+    uint first = start, capacity = p.slots, points = v.count;
+    int mode = v.mode == PlotMode::Lines ? 0 : 1;
+
+    //more samples than pixels, a min/max pair per pixel column keeps every spike
+    if (v.count > 2 * columns) {
+        if (p.reducedSize < columns) {
+            glDeleteBuffers(1, &p.reduced);
+            glGenBuffers(1, &p.reduced);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, p.reduced);
+            glBufferStorage(GL_COPY_WRITE_BUFFER, columns * 2 * (GLsizeiptr)sizeof(float), nullptr, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            p.reducedSize = columns;
+        }
+        state.useProgram(decimateShader);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, p.samples);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, p.reduced);
+        glUniform1ui(1, start);
+        glUniform1ui(2, p.slots);
+        glUniform1ui(3, v.count);
+        glUniform1ui(7, columns);
+        glDispatchCompute((columns + 63) / 64, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        state.calls += 9;
+        source = p.reduced;
+        first = 0;
+        capacity = columns * 2;
+        points = columns;
+        mode += 2;
+    }
+
+    state.useProgram(plotShader);
+    state.bindVertexArray(plotVAO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, source);
+    glUniform4f(0, x0 / fbw * 2.f - 1.f, y0, x1 / fbw * 2.f - 1.f, y1);
+    glUniform1ui(1, first);
+    glUniform1ui(2, capacity);
+    glUniform1ui(3, points);
+    glUniform2f(4, v.lo, v.hi);
+    glUniform1i(5, mode);
+    glUniform4f(6, (v.color & 0xFF) / 255.f, ((v.color >> 8) & 0xFF) / 255.f, ((v.color >> 16) & 0xFF) / 255.f, (v.color >> 24) / 255.f);
+    state.enable(GL_SCISSOR_TEST, true);
+    state.scissor((int)cx0, (int)(fbh - cy1), (int)(cx1 - cx0), (int)(cy1 - cy0));
+    glDrawArrays((mode & 1) == 0 ? GL_LINE_STRIP : GL_TRIANGLE_STRIP, 0, (GLsizei)(mode == 0 ? points : points * 2));
+    state.calls += 9;
+    ++drawCalls;
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::retirePlots() {
+    for (const std::unique_ptr<Plot>& ptr : plots) {
+        Plot& p = *ptr;
+        std::lock_guard<std::mutex> lock(p.lock);
+        //snapshots are drawn in order, a capture older than a drawn one was dropped with its snapshot
+        size_t drawn = 0;
+        for (size_t i = 0; i < p.captures.size(); ++i)
+            if (p.captures[i].serial != NotDrawn) drawn = i + 1;
+        while (!p.captures.empty()) {
+            const PlotCapture& c = p.captures.front();
+            if (c.serial != NotDrawn ? c.serial >= completedSerial : drawn <= 1) break;
+            p.captures.pop_front();
+            if (drawn != 0) --drawn;
         }
+        //a plot() to come reads at most capacity samples back from what is pushed now
+        const uint64_t pushed = p.pushed.load(std::memory_order_acquire);
+        uint64_t floor = pushed > p.capacity ? pushed - p.capacity : 0;
+        for (const PlotCapture& c : p.captures)
+            floor = std::min(floor, c.view.end - c.view.count);
+        if (floor > p.floor.load(std::memory_order_relaxed))
+            p.floor.store(floor, std::memory_order_release);
+    }
+}
+
+template<class Config>
+inline GLuint64 TurboGUI::GUI<Config>::textureHandle(GLuint _tex) {
+    auto it = textureHandles.find(_tex);
+    if (it != textureHandles.end())
+        return it->second;
+    const GLuint64 handle = glGetTextureHandleARB(_tex);
+    glMakeTextureHandleResidentARB(handle);
+    textureHandles.emplace(_tex, handle);
+    return handle;
+}
 
-        //Link
-        shader = glCreateProgram();
-        glAttachShader(shader, vertex);
-        glAttachShader(shader, frag);
+template<class Config>
+inline void TurboGUI::GUI<Config>::composite(GLuint _target, uint _width, uint _height) {
+    state.bindDrawFramebuffer(_target);
+    state.viewport(0, 0, (GLsizei)_width, (GLsizei)_height);
+    state.enable(GL_BLEND, true);
+    state.blendEquation(GL_FUNC_ADD, GL_FUNC_ADD);
+    state.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    state.enable(GL_CULL_FACE, false);
+    state.enable(GL_DEPTH_TEST, false);
+    state.polygonMode(GL_FILL);
+
+    state.useProgram(compositeShader);
+    state.bindVertexArray(VAO);
+    state.bindTexture(0, frameTex);
+    if (partialComposite) {
+        state.enable(GL_SCISSOR_TEST, true);
+        for (const DamageRect& d : damageRects) {
+            state.scissor(d.x, d.y, d.width, d.height);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            ++drawCalls;
+        }
+    } else {
+        state.enable(GL_SCISSOR_TEST, false);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        ++drawCalls;
+    }
+}
 
-        glLinkProgram(shader);
+template<class Config>
+inline void TurboGUI::GUI<Config>::trackDamage(ImDrawData* _data, bool _full) {
+    for (int n = 0; n < _data->CmdListsCount; n++) {
+        const ImDrawList* cmd_list = _data->CmdLists[n];
+        //the list drawn right before, a change means the stacking order changed
+        const ImDrawList* below = n == 0 ? nullptr : listKeys[n - 1];
+        auto it = damageLists.find(listKeys[n]);
+        if (it == damageLists.end()) {
+            DamageList& l = damageLists[listKeys[n]];
+            buildDamageItems(cmd_list, _data, l.items, l.bounds);
+            l.hash = listHashes[n];
+            l.below = below;
+            l.lastSeen = frameSerial;
+            addDamage(l.bounds);
+            continue;
+        }
+        DamageList& l = it->second;
+        l.lastSeen = frameSerial;
+        if (l.hash == listHashes[n] && l.below == below) continue;
 
-        GLint isLinked = 0;
-        glGetProgramiv(shader, GL_LINK_STATUS, (int*)&isLinked);
-        if (isLinked == GL_FALSE) {
-            GLint maxLength = 0;
-            glGetProgramiv(shader, GL_INFO_LOG_LENGTH, &maxLength);
-            std::vector<GLchar> errorLog(maxLength);
-            glGetProgramInfoLog(shader, maxLength, &maxLength, &errorLog[0]);
-            glDeleteShader(vertex);
-            glDeleteShader(frag);
-            if (shader != -1) glDeleteProgram(shader);
-            throw TurboGuiException(std::string(errorLog.data()));
+        ImVec4 bounds;
+        buildDamageItems(cmd_list, _data, damageScratch, bounds);
+        if (l.below != below) {
+            addDamage(l.bounds);
+            addDamage(bounds);
+        } else {
+            //commands are compared by position, an inserted command damages everything after it
+            const size_t count = std::max(l.items.size(), damageScratch.size());
+            for (size_t i = 0; i < count; ++i) {
+                if (i >= l.items.size())
+                    addDamage(damageScratch[i].rect);
+                else if (i >= damageScratch.size())
+                    addDamage(l.items[i].rect);
+                else if (l.items[i].hash != damageScratch[i].hash) {
+                    addDamage(l.items[i].rect);
+                    addDamage(damageScratch[i].rect);
+                }
+            }
         }
+        //a copy, a swap would hand the capacity of one list to the next and keep reallocating
+        l.items.assign(damageScratch.begin(), damageScratch.end());
+        l.bounds = bounds;
+        l.hash = listHashes[n];
+        l.below = below;
+    }
 
-        glDetachShader(shader, vertex);
-        glDetachShader(shader, frag);
+    //lists that disappeared leave their last rect behind
+    for (auto it = damageLists.begin(); it != damageLists.end();) {
+        if (it->second.lastSeen != frameSerial) {
+            addDamage(it->second.bounds);
+            it = damageLists.erase(it);
+        } else
+            ++it;
     }
 
-    {
-        //syncObj[0] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-        syncObj[1] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (_full) {
+        damage.clear();
+        damage.push_back(ImVec4(0.f, 0.f, _data->DisplaySize.x, _data->DisplaySize.y));
     }
- 
 }
 
-inline void TurboGUI::GUI::begin() {
-    time = std::chrono::high_resolution_clock::now();
-    ImGui::SetCurrentContext(context);
-    ImGui::NewFrame();   
+//splits the commands of _list into runs of quads and runs of triangles, returns the vertex slots of the split or 0
+template<class Config>
+inline uint TurboGUI::GUI<Config>::scanQuads(const ImDrawList* _list, std::vector<Segment>& _segments, ImVec2 _offset, ImVec2 _scale, uint _width, uint _height) {
+    _segments.clear();
+    uint quads = 0, triVerts = 0;
+    const float fbw = static_cast<float>(_width);
+    const float fbh = static_cast<float>(_height);
+    for (int cmd_i = 0; cmd_i < _list->CmdBuffer.Size; cmd_i++) {
+        const ImDrawCmd& cmd = _list->CmdBuffer[cmd_i];
+        const ImDrawIdx* idx = _list->IdxBuffer.Data + cmd.IdxOffset;
+        const ImDrawVert* vtx = _list->VtxBuffer.Data + cmd.VtxOffset;
+        //same test as clipCommands, culled commands are not worth scanning
+        const float x0 = (cmd.ClipRect.x - _offset.x) * _scale.x;
+        const float y0 = (cmd.ClipRect.y - _offset.y) * _scale.y;
+        const float x1 = (cmd.ClipRect.z - _offset.x) * _scale.x;
+        const float y1 = (cmd.ClipRect.w - _offset.y) * _scale.y;
+        if (cmd.UserCallback || !(x0 < fbw && y0 < fbh && x1 >= 0.f && y1 >= 0.f)) {
+            _segments.push_back({ (uint)cmd_i, 0, cmd.ElemCount, 1, 0, false });
+            continue;
+        }
+        const auto triangles = [&](uint _first, uint _end) {
+            if (_first == _end) return;
+            Segment g{ (uint)cmd_i, _first, _end - _first, ~0u, 0, false };
+            for (uint k = _first; k < _end; ++k) {
+                g.vtxMin = std::min<uint>(g.vtxMin, idx[k]);
+                g.vtxMax = std::max<uint>(g.vtxMax, idx[k]);
+            }
+            triVerts += g.vtxMax - g.vtxMin + 1;
+            _segments.push_back(g);
+        };
+        uint k = 0, begin = 0;
+        while (k + 6 <= cmd.ElemCount) {
+            uint end = k;
+            while (end + 6 <= cmd.ElemCount && isQuad(idx + end, vtx))
+                end += 6;
+            if (end - k >= MinQuadRun * 6) {
+                triangles(begin, k);
+                _segments.push_back({ (uint)cmd_i, k, end - k, 0, 0, true });
+                quads += (end - k) / 6;
+                begin = k = end;
+            } else
+                k = end == k ? k + 3 : end;
+        }
+        triangles(begin, cmd.ElemCount);
+    }
+    //lists with hardly any quads are not worth the split
+    const uint slots = triVerts + quadSlots(quads);
+    return quads != 0 && slots <= static_cast<uint>(_list->VtxBuffer.Size) ? slots : 0;
 }
 
-inline void TurboGUI::GUI::draw() {
+//neighbours with the same texture and vertex base whose indices follow each other become one draw if their
+//scissors are the same within the framebuffer. with _bounds they may differ as long as the geometry of every
+//merged command stays within its own scissor, the draw then gets the box around all of them
+template<class Config>
+inline void TurboGUI::GUI<Config>::mergeCommands(bool _bounds, ImVec2 _offset, ImVec2 _scale, uint _width, uint _height) {
+    //[x0, y0, x1, y1) in window coordinates, cut by the framebuffer
+    struct Rect {
+        int x0, y0, x1, y1;
+        bool operator==(const Rect& _r) const { return x0 == _r.x0 && y0 == _r.y0 && x1 == _r.x1 && y1 == _r.y1; }
+        bool contains(const Rect& _r) const { return x0 <= _r.x0 && y0 <= _r.y0 && x1 >= _r.x1 && y1 >= _r.y1; }
+    };
+    const auto scissor = [&](uint _i) {
+        return Rect{ std::max(cmds.x[_i], 0), std::max(cmds.y[_i], 0),
+            std::min(cmds.x[_i] + cmds.width[_i], (int)_width), std::min(cmds.y[_i] + cmds.height[_i], (int)_height) };
+    };
+    //a pixel is only covered if its center is, so bounds within the rect draw nothing outside of it
+    const auto inside = [&](uint _i, const Rect& _r) {
+        float x0 = FLT_MAX, y0 = FLT_MAX, x1 = -FLT_MAX, y1 = -FLT_MAX;
+        const ImDrawIdx* idx = cmds.srcIdx[_i];
+        const ImDrawVert* vtx = cmds.srcVtx[_i];
+        for (uint k = 0; k < cmds.elemCount[_i]; ++k) {
+            const ImVec2 p = vtx[idx[k]].pos;
+            x0 = std::min(x0, p.x);
+            y0 = std::min(y0, p.y);
+            x1 = std::max(x1, p.x);
+            y1 = std::max(y1, p.y);
+        }
+        x0 = (x0 - _offset.x) * _scale.x;
+        x1 = (x1 - _offset.x) * _scale.x;
+        //window y grows upwards
+        const float top = (float)_height - (y0 - _offset.y) * _scale.y;
+        const float bottom = (float)_height - (y1 - _offset.y) * _scale.y;
+        return x0 >= (float)_r.x0 && x1 <= (float)_r.x1 && bottom >= (float)_r.y0 && top <= (float)_r.y1;
+    };
 
-    ImGui::Render();
+    //whether the geometry of the run is known to stay within the scissor of the run. only a run of a single
+    //command is checked on demand, merges keep track of it from there
+    enum { Unknown, Tight, Loose };
+    uint prev = ~0u;
+    Rect run{};
+    int tight = Unknown;
+    for (uint i = 0; i < cmds.size; ++i) {
+        //nothing merges across a callback
+        if (cmds.callback[i]) {
+            prev = ~0u;
+            continue;
+        }
+        if (!cmds.visible[i]) continue;
+        if (cmds.elemCount[i] == 0) {
+            cmds.visible[i] = 0;
+            continue;
+        }
+        const Rect r = scissor(i);
+        if (prev != ~0u && cmds.texture[prev] == cmds.texture[i] && cmds.quad[prev] == cmds.quad[i] && cmds.baseVertex[prev] == cmds.baseVertex[i]
+            && cmds.firstIndex[prev] + cmds.elemCount[prev] == cmds.firstIndex[i]) {
+            bool merge = false;
+            if (r == run) {
+                merge = true;
+                tight = Loose;
+            } else if (_bounds && run.contains(r))
+                merge = inside(i, r);
+            else if (_bounds) {
+                if (tight == Unknown)
+                    tight = inside(prev, run) ? Tight : Loose;
+                if (tight == Tight && inside(i, r)) {
+                    merge = true;
+                    run = { std::min(run.x0, r.x0), std::min(run.y0, r.y0), std::max(run.x1, r.x1), std::max(run.y1, r.y1) };
+                    cmds.x[prev] = run.x0;
+                    cmds.y[prev] = run.y0;
+                    cmds.width[prev] = run.x1 - run.x0;
+                    cmds.height[prev] = run.y1 - run.y0;
+                }
+            }
+            if (merge) {
+                cmds.elemCount[prev] += cmds.elemCount[i];
+                cmds.visible[i] = 0;
+                ++mergedDraws;
+                continue;
+            }
+        }
+        prev = i;
+        run = r;
+        tight = Unknown;
+    }
+}
 
-	auto draw_data = ImGui::GetDrawData();
+template<class Config>
+inline void TurboGUI::GUI<Config>::buildDamageItems(const ImDrawList* _list, ImDrawData* _data, std::vector<DamageItem>& _items, ImVec4& _bounds) {
+    const ImVec2 clip_off = _data->DisplayPos;
+    const ImVec2 clip_scale = _data->FramebufferScale;
+    const float width = _data->DisplaySize.x, height = _data->DisplaySize.y;
 
-    const ImVec2 clip_off = draw_data->DisplayPos;         // (0,0) unless using multi-viewports
-    const ImVec2 clip_scale = draw_data->FramebufferScale; // (1,1) unless using retina display which are often (2,2)
+    _items.resize(_list->CmdBuffer.Size);
+    _bounds = ImVec4(width, height, 0.f, 0.f);
+    for (int cmd_i = 0; cmd_i < _list->CmdBuffer.Size; cmd_i++) {
+        const ImDrawCmd& cmd = _list->CmdBuffer[cmd_i];
+        DamageItem& item = _items[cmd_i];
+        item.rect = ImVec4(0.f, 0.f, 0.f, 0.f);
 
-    std::vector<std::tuple<const ImDrawCmd*, uint, uint>> cmdCache;
+        const ImDrawIdx* idx_data = _list->IdxBuffer.Data + cmd.IdxOffset;
+        uint lo = ~0u, hi = 0;
+        for (uint i = 0; i < cmd.ElemCount; ++i) {
+            lo = std::min(lo, (uint)idx_data[i]);
+            hi = std::max(hi, (uint)idx_data[i]);
+        }
 
-    //pre-run
-    {
-        uint old_v_offset = 0;
-        uint old_i_offset = 0;
-        uint idx_offset = 0;
-        uint v_offset = 0;
+        const uint counts[3] = { cmd.ElemCount, lo, hi };
+        item.hash = hashBytes(counts, sizeof(counts), hashBytes(idx_data, cmd.ElemCount * sizeof(ImDrawIdx), 0));
+        item.hash = hashBytes(&cmd.ClipRect, sizeof(ImVec4), item.hash);
+        item.hash = hashBytes(&cmd.TextureId, sizeof(ImTextureID), item.hash);
+        if (cmd.ElemCount == 0) continue;
 
-        for (int n = 0; n < draw_data->CmdListsCount; n++) {
-            const ImDrawList* cmd_list = draw_data->CmdLists[n];
-            std::memcpy(VBO_ptr[currIndex] + v_offset*5, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * (uint)sizeof(ImDrawVert));
-            std::memcpy(EBO_ptr[currIndex] + idx_offset, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * (uint)sizeof(ImDrawIdx));
+        const ImDrawVert* vtx_data = _list->VtxBuffer.Data + cmd.VtxOffset;
+        item.hash = hashBytes(vtx_data + lo, (hi - lo + 1) * sizeof(ImDrawVert), item.hash);
+        ImVec2 mn = vtx_data[lo].pos, mx = vtx_data[lo].pos;
+        for (uint v = lo + 1; v <= hi; ++v) {
+            mn = ImVec2(std::min(mn.x, vtx_data[v].pos.x), std::min(mn.y, vtx_data[v].pos.y));
+            mx = ImVec2(std::max(mx.x, vtx_data[v].pos.x), std::max(mx.y, vtx_data[v].pos.y));
+        }
+
+        //pixels touched by the triangles, cut by the clip rect and the screen
+        const float x0 = std::max({ std::floor((mn.x - clip_off.x) * clip_scale.x) - 1.f, std::floor((cmd.ClipRect.x - clip_off.x) * clip_scale.x), 0.f });
+        const float y0 = std::max({ std::floor((mn.y - clip_off.y) * clip_scale.y) - 1.f, std::floor((cmd.ClipRect.y - clip_off.y) * clip_scale.y), 0.f });
+        const float x1 = std::min({ std::ceil((mx.x - clip_off.x) * clip_scale.x) + 1.f, std::ceil((cmd.ClipRect.z - clip_off.x) * clip_scale.x), width });
+        const float y1 = std::min({ std::ceil((mx.y - clip_off.y) * clip_scale.y) + 1.f, std::ceil((cmd.ClipRect.w - clip_off.y) * clip_scale.y), height });
+        if (x0 >= x1 || y0 >= y1) continue;
+        item.rect = ImVec4(x0, y0, x1, y1);
+        _bounds = ImVec4(std::min(_bounds.x, x0), std::min(_bounds.y, y0), std::max(_bounds.z, x1), std::max(_bounds.w, y1));
+    }
+}
 
-            v_offset += cmd_list->VtxBuffer.Size;
-            idx_offset += cmd_list->IdxBuffer.Size;
+template<class Config>
+inline void TurboGUI::GUI<Config>::addDamage(ImVec4 _rect) {
+    if (_rect.x >= _rect.z || _rect.y >= _rect.w) return;
 
-            for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
-                auto cmd = &cmd_list->CmdBuffer[cmd_i];
-                cmdCache.push_back({ cmd, old_v_offset, old_i_offset });
+    const auto area = [](const ImVec4& _r) { return (_r.z - _r.x) * (_r.w - _r.y); };
+    const auto unite = [](const ImVec4& _a, const ImVec4& _b) {
+        return ImVec4(std::min(_a.x, _b.x), std::min(_a.y, _b.y), std::max(_a.z, _b.z), std::max(_a.w, _b.w));
+    };
+
+    //merge until the rect overlaps nothing. past MaxDamageRects it goes into the rect it grows the least
+    for (;;) {
+        size_t hit = damage.size();
+        for (size_t i = 0; i < damage.size() && hit == damage.size(); ++i)
+            if (_rect.x < damage[i].z && damage[i].x < _rect.z && _rect.y < damage[i].w && damage[i].y < _rect.w)
+                hit = i;
+        if (hit == damage.size() && damage.size() >= MaxDamageRects) {
+            float best = 0.f;
+            for (size_t i = 0; i < damage.size(); ++i) {
+                const float cost = area(unite(damage[i], _rect)) - area(damage[i]);
+                if (hit == damage.size() || cost < best) {
+                    best = cost;
+                    hit = i;
+                }
             }
-            old_v_offset = v_offset;
-            old_i_offset = idx_offset;
         }
+        if (hit == damage.size()) break;
+        _rect = unite(_rect, damage[hit]);
+        damage[hit] = damage.back();
+        damage.pop_back();
+    }
+    damage.push_back(_rect);
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::setRetainedFrame(bool _retain) {
+    static_assert(Config::Retained, "the retained frame is disabled by the config");
+    retainFrame = _retain;
+    dirty = true;
+    if (!_retain)
+        damageTracking = partialComposite = false;
+    frameWidth = 0;
+    frameHeight = 0;
+    state.forgetTexture(frameTex);
+    glDeleteTextures(1, &frameTex);
+    frameTex = 0;
+    if (_retain && frameFBO == 0)
+        glGenFramebuffers(1, &frameFBO);
+    if (!_retain) {
+        glDeleteFramebuffers(1, &frameFBO);
+        frameFBO = 0;
+    }
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::updateDrawTime() {
+    if constexpr (!Config::Stats)
+        return;
+    const auto now = clock();
+    cpuPhases.upload = static_cast<float>(uploadTime) * 1e-6f;
+    cpuPhases.sync = static_cast<float>(syncTime) * 1e-6f;
+    cpuPhases.submit = std::max(0.f, std::chrono::duration<float, std::milli>(now - drawStart).count() - cpuPhases.upload - cpuPhases.sync);
+    auto deltaT = now - time;
+    long long ns = deltaT.count();
+    drawTime = 1.f / static_cast<float>(1e6) * static_cast<float>(ns);
+    drawEnd = now;
+    //running sum over the ring instead of summing it up every frame
+    drawMeanTimeIndex = (drawMeanTimeIndex + 1) % drawTimeMean.size();
+    drawTimeSum += drawTime - drawTimeMean[drawMeanTimeIndex];
+    drawTimeMean[drawMeanTimeIndex] = drawTime;
+    meanTime = std::max(0.f, drawTimeSum) / drawTimeMean.size();
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::waitForBegin() {
+    if (!pacing || !delayedBegin || pipeline || begun) return;
+    begun = true;
+    const FramePacer::Clock::time_point now = FramePacer::Clock::now();
+    //the frame is due once the gpu has room for it and the frame rate target allows it
+    FramePacer::Clock::time_point due = now;
+    if (maxQueued != 0 && queuedFrames >= maxQueued)
+        due = std::max(due, pacer.predict(frameSerial - maxQueued));
+    if (framePeriod > 0.f)
+        due = std::max(due, pacer.next(framePeriod));
+    const FramePacer::Clock::time_point start = pacer.start(due);
+    if (start > now)
+        std::this_thread::sleep_until(start);
+}
 
-        idx = idx_offset;
-        vert = v_offset;
+template<class Config>
+inline void TurboGUI::GUI<Config>::sync() {
+    syncStart = clock();
+    if (pacing)
+        pacer.ready(frameSerial, FramePacer::Clock::now());
+    //regions the gpu already finished with are released without blocking
+    while (regionCount > 0) {
+        const GLenum res = glClientWaitSync(regions[regionFirst].fence, 0, 0);
+        if (res != GL_ALREADY_SIGNALED && res != GL_CONDITION_SATISFIED) break;
+        retireRegion(false);
+    }
+    for (size_t i = 0; i < retired.size();) {
+        const GLenum res = glClientWaitSync(retired[i].fence, 0, 0);
+        if (res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED) {
+            glDeleteBuffers(1, &retired[i].vbo);
+            glDeleteBuffers(1, &retired[i].ebo);
+            glDeleteBuffers(1, &retired[i].cbo);
+            glDeleteBuffers(1, &retired[i].infobo);
+            glDeleteSync(retired[i].fence);
+            retired[i] = retired.back();
+            retired.pop_back();
+        } else
+            ++i;
+    }
 
-        maxIdx = std::max(idx, maxIdx);
-        maxVert = std::max(vert, maxVert);
+    for (size_t i = 0; i < arenaFrees.size();) {
+        const ArenaFree& f = arenaFrees[i];
+        if (f.serial < completedSerial) {
+            vtxArena.release(f.vtx, f.vtxCount);
+            idxArena.release(f.idx, f.idxCount);
+            arenaFrees[i] = arenaFrees.back();
+            arenaFrees.pop_back();
+        } else
+            ++i;
     }
 
-    //draw
-    {
-        glEnable(GL_BLEND);
-        glBlendEquation(GL_FUNC_ADD);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glDisable(GL_CULL_FACE);
-        glDisable(GL_DEPTH_TEST);
-        glEnable(GL_SCISSOR_TEST);
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-        bool clip_origin_lower_left = true;
-#if defined(GL_CLIP_ORIGIN) && !defined(__APPLE__)
-        GLenum current_clip_origin = 0; glGetIntegerv(GL_CLIP_ORIGIN, (GLint*)&current_clip_origin);
-        if (current_clip_origin == GL_UPPER_LEFT)
-            clip_origin_lower_left = false;
-#endif
+    //no wait on the frame count unless capped, reserve() waits when the ring wraps into a region in flight
+    while (maxQueued != 0 && queuedFrames >= maxQueued)
+        waitFrame();
+    if (!plots.empty())
+        retirePlots();
 
-        glUseProgram(shader);
-        glBindVertexArray(VAO[currIndex]);
+    closeRegion(true);
+    if (pacing && framePeriod > 0.f)
+        pacer.limit(framePeriod, !delayedBegin || pipeline != nullptr);
 
-        uint fb_width = static_cast<uint>(draw_data->DisplaySize.x);
-        uint fb_height = static_cast<uint>(draw_data->DisplaySize.y);
+    if constexpr (Config::Stats) {
+        cpuPhases.sync = static_cast<float>(syncTime) * 1e-6f;
+        recordMetrics();
+        //after the record, the queries of this frame may already be available
+        readGpuTimers();
+    }
+}
 
-        glViewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height);
-        const float L = draw_data->DisplayPos.x;
-        const float R = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
-        const float T = draw_data->DisplayPos.y;
-        const float B = draw_data->DisplayPos.y + draw_data->DisplaySize.y;
-        const float ortho_projection[4][4] =
-        {
-            { 2.f / (R - L),        0.f,                0.0f,       0.0f },
-            { 0.f,                  2.f / (T - B),      0.0f,       0.0f },
-            { 0.f,                  0.f,                -1.0f,      0.0f },
-            { (R + L) / (L - R),    (T + B) / (B - T),  0.0f,       1.0f },
-        };
+template<class Config>
+inline void TurboGUI::GUI<Config>::recordMetrics() {
+    drawTimeHist.record(drawTime);
+    syncTimeHist.record(syncTime * 1e-6);
+    uploadHist.record(uploadBytes);
+    drawCallHist.record(drawCalls);
+    ++metricFrames;
 
-        glUniform1i(4, 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, tex);
-        glUniformMatrix4fv(3, 1, GL_FALSE, &ortho_projection[0][0]);
+    MetricsSnapshot snap;
+    snap.frames = metricFrames;
+    snap.drawTime = drawTimeHist.stats();
+    snap.syncTime = syncTimeHist.stats();
+    snap.uploadBytes = uploadHist.stats();
+    snap.drawCalls = drawCallHist.stats();
+    snap.phases = cpuPhases;
+    snap.gpuTime = gpuTime;
+    metrics.store(snap);
 
-        for (size_t i = 0; i < cmdCache.size(); ++i) {
-            
-            const auto cmd = std::get<0>(cmdCache[i]);
-
-            ImVec4 clip_rect;
-            clip_rect.x = (cmd->ClipRect.x - clip_off.x) * clip_scale.x;
-            clip_rect.y = (cmd->ClipRect.y - clip_off.y) * clip_scale.y;
-            clip_rect.z = (cmd->ClipRect.z - clip_off.x) * clip_scale.x;
-            clip_rect.w = (cmd->ClipRect.w - clip_off.y) * clip_scale.y;
-            if (clip_rect.x < fb_width && clip_rect.y < fb_height && clip_rect.z >= 0.f && clip_rect.w >= 0.f) {
-                glScissor((int)clip_rect.x, (int)(fb_height - clip_rect.w), (int)(clip_rect.z - clip_rect.x), (int)(clip_rect.w - clip_rect.y));
-                const uint voffset = (GLint)std::get<1>(cmdCache[i]);
-                const uint ioffset = (GLint)std::get<2>(cmdCache[i]);
-                glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)cmd->ElemCount, GL_UNSIGNED_SHORT, (void*)(intptr_t)((cmd->IdxOffset + ioffset) * sizeof(ImDrawIdx)), voffset);
-                //glDrawElements(GL_TRIANGLES, (GLsizei)cmd->ElemCount, GL_UNSIGNED_SHORT, (void*)(intptr_t)((cmd->IdxOffset + ioffset) * sizeof(ImDrawIdx)));
-            }
+    if (traceFrames.empty()) return;
+    //frameSerial was advanced by closeRegion(), the frame just ended is the one before
+    const auto us = [&](std::chrono::high_resolution_clock::time_point _t) {
+        return std::chrono::duration<double, std::micro>(_t - traceEpoch).count();
+    };
+    const uint frame = frameSerial - 1;
+    ++traceCount;
+    traceFrames[frame % traceFrames.size()] = { frame, us(time), us(drawStart), us(drawEnd), us(syncStart), us(clock()),
+        cpuPhases.upload, cpuPhases.submit, -1.f, uploadBytes, drawCalls };
+}
 
-        }
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glBindVertexArray(0);
-        glUseProgram(0);       
+template<class Config>
+inline void TurboGUI::GUI<Config>::resetMetrics() {
+    drawTimeHist.reset();
+    syncTimeHist.reset();
+    uploadHist.reset();
+    drawCallHist.reset();
+    metricFrames = 0;
+    metrics.store(MetricsSnapshot());
+}
 
-        glScissor(0, 0, (GLsizei)draw_data->DisplaySize.x, (GLsizei)draw_data->DisplaySize.y);
+template<class Config>
+inline void TurboGUI::GUI<Config>::exportMetricsCSV(std::ostream& _out) const {
+    const MetricsSnapshot snap = getMetrics();
+    const std::pair<const char*, const MetricStats*> rows[] = {
+        { "draw_time_ms", &snap.drawTime }, { "sync_time_ms", &snap.syncTime }, { "upload_bytes", &snap.uploadBytes }, { "draw_calls", &snap.drawCalls }
+    };
+    const std::ios::fmtflags flags = _out.flags(std::ios::fixed);
+    const std::streamsize precision = _out.precision(4);
+    _out << "metric,count,mean,p50,p95,p99,max\n";
+    for (const auto& row : rows) {
+        const MetricStats& m = *row.second;
+        _out << row.first << ',' << m.count << ',' << m.mean << ',' << m.p50 << ',' << m.p95 << ',' << m.p99 << ',' << m.max << '\n';
     }
-    {
-        auto deltaT = std::chrono::high_resolution_clock::now() - time;
-        long long ns = deltaT.count();
-        drawTime = 1.f / static_cast<float>(1e6) * static_cast<float>(ns);
-        drawMeanTimeIndex = (++drawMeanTimeIndex) % drawTimeMean.size();
-        drawTimeMean[drawMeanTimeIndex] = drawTime;
-        meanTime = std::accumulate(drawTimeMean.begin(), drawTimeMean.end(), 0.f);
-        meanTime /= drawTimeMean.size();
+    _out.flags(flags);
+    _out.precision(precision);
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::setTraceCapture(uint _frames) {
+    static_assert(Config::Stats, "the trace needs a config with Stats");
+    traceFrames.assign(_frames, FrameRecord());
+    traceCount = 0;
+    traceEpoch = clock();
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::exportChromeTrace(std::ostream& _out) const {
+    //complete events on tid 1 for the cpu, tid 2 for the gpu (placed at the start of draw(), the timestamps
+    //are not on the cpu clock) and counters for the upload
+    const uint n = std::min<uint>(traceCount, (uint)traceFrames.size());
+    //us with ns resolution, never in exponent notation
+    const std::ios::fmtflags flags = _out.flags(std::ios::fixed);
+    const std::streamsize precision = _out.precision(3);
+    _out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    const auto event = [&](const char* _name, uint _tid, double _ts, double _dur, uint _frame) {
+        _out << (first ? "" : ",") << "{\"name\":\"" << _name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << _tid
+            << ",\"ts\":" << _ts << ",\"dur\":" << _dur << ",\"args\":{\"frame\":" << _frame << "}}";
+        first = false;
+    };
+    const uint last = frameSerial - 1;
+    for (uint frame = last + 1 - n; frame != last + 1; ++frame) {
+        const FrameRecord& r = traceFrames[frame % traceFrames.size()];
+        if (r.frame != frame) continue;
+        event("imgui", 1, r.begin, r.draw - r.begin, r.frame);
+        event("draw", 1, r.draw, r.drawEnd - r.draw, r.frame);
+        event("upload", 1, r.draw, r.upload * 1e3, r.frame);
+        event("sync", 1, r.sync, r.syncEnd - r.sync, r.frame);
+        if (r.gpu >= 0.f)
+            event("gpu", 2, r.draw, r.gpu * 1e3, r.frame);
+        _out << ",{\"name\":\"upload\",\"ph\":\"C\",\"pid\":1,\"ts\":" << r.draw << ",\"args\":{\"bytes\":" << r.bytes << ",\"draws\":" << r.draws << "}}";
+    }
+    _out << "]}\n";
+    _out.flags(flags);
+    _out.precision(precision);
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::createStorage() {
+    vtxCapacity = vertBound * framesInFlight;
+    idxCapacity = idxBound * framesInFlight;
+    cmdCapacity = cmdBound * framesInFlight;
+    vtxHead = 0;
+    idxHead = 0;
+    cmdHead = 0;
+    //regions of older storages never overlap the new one
+    ++storageGen;
+
+    //the arena lives behind the ring and starts out empty
+    vtxArena.reset(arenaVert);
+    idxArena.reset(arenaIdx);
+    arenaFrees.clear();
+    for (auto& e : listCache)
+        e.second.resident = false;
+    GLbitfield storageFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_CLIENT_STORAGE_BIT;
+    GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    if (mapMode == MapMode::Coherent) {
+        storageFlags |= GL_MAP_COHERENT_BIT;
+        mapFlags |= GL_MAP_COHERENT_BIT;
+    } else if (mapMode == MapMode::ExplicitFlush)
+        mapFlags |= GL_MAP_FLUSH_EXPLICIT_BIT;
+
+    const uint vtxSize = vtxCapacity + arenaVert;
+    const uint idxSize = idxCapacity + arenaIdx;
+
+    //a slice of the renderer's arena if it fits, buffers of its own otherwise
+    sharedStorage = renderer && renderer->allocate(vtxSize, idxSize, vtxBase, idxBase);
+    if (sharedStorage) {
+        VBO = renderer->VBO;
+        EBO = renderer->EBO;
+        vtxSlice = vtxSize;
+        idxSlice = idxSize;
+    } else {
+        vtxBase = 0;
+        idxBase = 0;
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+    }
+    glGenBuffers(1, &CBO);
+    glGenBuffers(1, &InfoBO);
+
+    state.bindVertexArray(VAO);
+
+    //vbo
+    if (sharedStorage)
+        VBO_ptr = renderer->VBO_ptr + vtxBase * (size_t)vertSize;
+    else {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferStorage(GL_ARRAY_BUFFER, vtxSize * (GLsizeiptr)vertSize, nullptr, storageFlags);
+        VBO_ptr = reinterpret_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, vtxSize * (GLsizeiptr)vertSize, mapFlags));
+    }
+    glBindVertexBuffer(0, VBO, vtxBase * (GLintptr)vertSize, vertSize);
+    if (packed()) {
+        //integer positions, PackedPosScale is folded into the projection
+        glVertexAttribFormat(0, 2, GL_SHORT, GL_FALSE, IM_OFFSETOF(PackedVert, pos));
+        glVertexAttribFormat(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, IM_OFFSETOF(PackedVert, uv));
+        glVertexAttribFormat(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, IM_OFFSETOF(PackedVert, col));
+    } else {
+        glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, IM_OFFSETOF(ImDrawVert, pos));
+        glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, IM_OFFSETOF(ImDrawVert, uv));
+        glVertexAttribFormat(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, IM_OFFSETOF(ImDrawVert, col));
+    }
+
+    //ebo
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    if (sharedStorage)
+        EBO_ptr = renderer->EBO_ptr + idxBase;
+    else {
+        glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, idxSize * (GLsizeiptr)sizeof(ImDrawIdx), nullptr, storageFlags);
+        EBO_ptr = reinterpret_cast<ImDrawIdx*>(glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, idxSize * (GLsizeiptr)sizeof(ImDrawIdx), mapFlags));
     }
+
+    //indirect records
+    state.bindIndirectBuffer(CBO);
+    glBufferStorage(GL_DRAW_INDIRECT_BUFFER, cmdCapacity * (GLsizeiptr)sizeof(DrawElementsIndirectCommand), nullptr, storageFlags);
+    CBO_ptr = reinterpret_cast<DrawElementsIndirectCommand*>(glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, cmdCapacity * (GLsizeiptr)sizeof(DrawElementsIndirectCommand), mapFlags));
+    state.bindIndirectBuffer(0);
+
+    //draw infos, read as instanced attributes or as ssbo
+    glBindBuffer(GL_ARRAY_BUFFER, InfoBO);
+    glBufferStorage(GL_ARRAY_BUFFER, cmdCapacity * (GLsizeiptr)sizeof(DrawInfo), nullptr, storageFlags);
+    Info_ptr = reinterpret_cast<DrawInfo*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, cmdCapacity * (GLsizeiptr)sizeof(DrawInfo), mapFlags));
+    glBindVertexBuffer(1, InfoBO, 0, sizeof(DrawInfo));
+
+    state.bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (!VBO_ptr || !EBO_ptr || !CBO_ptr || !Info_ptr)
+        throw TurboGuiException("failed to map the vertex storage");
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::grow(uint _vert, uint _idx, uint _cmd) {
+    //the old storage stays alive until the gpu passed everything submitted so far
+    if (sharedStorage) {
+        renderer->release(vtxBase, vtxSlice, idxBase, idxSlice);
+        retired.push_back({ 0, 0, CBO, InfoBO, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    } else
+        retired.push_back({ VBO, EBO, CBO, InfoBO, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    vertBound = _vert;
+    idxBound = _idx;
+    cmdBound = _cmd;
+    createStorage();
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::retireRegion(bool _block) {
+    FrameRegion& r = regions[regionFirst];
+    bool waited = false;
+    if (_block) {
+        auto t = clock();
+        GLenum res;
+        while ((res = glClientWaitSync(r.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeOutSync)) == GL_TIMEOUT_EXPIRED)
+            ++syncTimeOuts;
+        waited = res == GL_CONDITION_SATISFIED;
+        syncTime += static_cast<uint>((clock() - t).count());
+    }
+    if (r.frameEnd) {
+        --queuedFrames;
+        completedSerial = r.serial + 1;
+        if (pacing)
+            pacer.complete(r.serial, FramePacer::Clock::now(), waited);
+    }
+    glDeleteSync(r.fence);
+    r.fence = nullptr;
+    regionFirst = (regionFirst + 1) % MaxRegions;
+    --regionCount;
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::waitFrame() {
+    const FrameRegion& r = regions[regionFirst];
+    if (pacing && r.frameEnd) {
+        auto t = clock();
+        const FramePacer::Clock::time_point due = pacer.predict(r.serial);
+        const FramePacer::Wait wait = pacer.strategy(r.serial, FramePacer::Clock::now());
+        pacer.count(wait);
+        if (wait == FramePacer::Wait::Sleep)
+            std::this_thread::sleep_until(due - FramePacer::duration(FramePacer::SleepMargin));
+        else if (wait == FramePacer::Wait::Poll) {
+            //a late frame is polled for one more PollTime before it is blocked on
+            const FramePacer::Clock::time_point end = std::max(due, FramePacer::Clock::now()) + FramePacer::duration(FramePacer::PollTime);
+            while (FramePacer::Clock::now() < end) {
+                const GLenum res = glClientWaitSync(r.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+                if (res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED) break;
+                std::this_thread::yield();
+            }
+        }
+        syncTime += static_cast<uint>((clock() - t).count());
+    }
+    retireRegion(true);
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::closeRegion(bool _frameEnd) {
+    if (regionCount == MaxRegions)
+        waitFrame();
+
+    pending.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pending.frameEnd = _frameEnd;
+    pending.serial = frameSerial;
+    regions[(regionFirst + regionCount) % MaxRegions] = pending;
+    ++regionCount;
+    if (_frameEnd) {
+        if (pacing)
+            pacer.submit(frameSerial, FramePacer::Clock::now());
+        ++queuedFrames;
+        ++frameSerial;
+    }
+    pending = FrameRegion{ nullptr, storageGen, false, vtxHead, vtxHead, idxHead, idxHead, cmdHead, cmdHead };
+}
+
+template<class Config>
+inline void TurboGUI::GUI<Config>::releaseCached(CachedList& _e) {
+    if (!_e.resident) return;
+    //frames in flight may still draw from the blocks
+    arenaFrees.push_back({ _e.vtx, _e.vtxCount, _e.idx, _e.idxCount, frameSerial });
+    _e.resident = false;
 }
 
-inline void TurboGUI::GUI::sync() {
-    uint syncI = (currIndex + 1) % 2;
-    auto t = std::chrono::high_resolution_clock::now();
-    glClientWaitSync(syncObj[syncI], GL_SYNC_FLUSH_COMMANDS_BIT, timeOutSync);
-    syncTime = static_cast<uint>((std::chrono::high_resolution_clock::now() - t).count());
-    glDeleteSync(syncObj[syncI]);
-    syncObj[currIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-    currIndex = syncI;
+template<class Config>
+inline void TurboGUI::GUI<Config>::reserve(uint _vtx, uint _idx, uint _cmd) {
+    //chunks are sized to the per-frame bound, a larger request would run into regions still in flight
+    if (_vtx > vertBound || _idx > idxBound || _cmd > cmdBound)
+        throw TurboGuiException("a chunk exceeds the per-frame storage bound");
+    //a range never wraps around the end of the ring, it starts over at 0 instead
+    const uint vtxBegin = vtxHead + _vtx <= vtxCapacity ? vtxHead : 0;
+    const uint idxBegin = idxHead + _idx <= idxCapacity ? idxHead : 0;
+    const uint cmdBegin = cmdHead + _cmd <= cmdCapacity ? cmdHead : 0;
+
+    const auto overlaps = [](uint _b0, uint _e0, uint _b1, uint _e1) {
+        return _b0 < _e1 && _b1 < _e0;
+    };
+
+    //only block while the new range runs into memory the gpu may still read
+    while (regionCount > 0) {
+        bool hit = false;
+        for (uint i = 0; i < regionCount && !hit; ++i) {
+            const FrameRegion& o = regions[(regionFirst + i) % MaxRegions];
+            hit = o.storage == storageGen && (overlaps(vtxBegin, vtxBegin + _vtx, o.vtxBegin, o.vtxEnd) || overlaps(idxBegin, idxBegin + _idx, o.idxBegin, o.idxEnd)
+                || overlaps(cmdBegin, cmdBegin + _cmd, o.cmdBegin, o.cmdEnd));
+        }
+        if (!hit) break;
+        waitFrame();
+    }
+
+    pending = FrameRegion{ nullptr, storageGen, false, vtxBegin, vtxBegin + _vtx, idxBegin, idxBegin + _idx, cmdBegin, cmdBegin + _cmd };
+    vtxHead = pending.vtxEnd;
+    idxHead = pending.idxEnd;
+    cmdHead = pending.cmdEnd;
 }
 
-inline void TurboGUI::GUI::drawStatsWindow(uint _fps) {
+template<class Config>
+inline void TurboGUI::GUI<Config>::drawStatsWindow(uint _fps) {
     maxFps = std::max(maxFps, _fps);
     bool open = true;
 
@@ -388,25 +5200,86 @@ inline void TurboGUI::GUI::drawStatsWindow(uint _fps) {
     ImGui::Text("fps: %i [%i]", _fps, maxFps);
     //draw time
     ImGui::Text("time: %.3fms [%.3fms]", drawTime, meanTime);
+    //tail latency since resetMetrics()
+    {
+        const MetricStats t = metrics.load().drawTime;
+        ImGui::Text("p50: %.3fms p99: %.3fms max: %.3fms", t.p50, t.p99, t.max);
+    }
     //vertices
     ImGui::Text("vert: %i [%i] [%i]", vert, maxVert, vertBound);
     //indices
     ImGui::Text("idx: %i [%i] [%i]", idx, maxIdx, idxBound);
     //timeout
-    ImGui::Text("sync: %i [%i] [%i]", syncTime, timeOutSync, timeOutSync - syncTime);
+    ImGui::Text("sync: %i [%i] [%i]", syncTime, timeOutSync, syncTimeOuts);
+    //frames the gpu is behind
+    ImGui::Text("frames: %i [%i]", queuedFrames, framesInFlight);
+    //startup
+    ImGui::Text("init: %.3fms [%i]", initTime, programCacheHits);
+    //cpu phases
+    ImGui::Text("cpu: imgui %.3f upload %.3f submit %.3f sync %.3f", cpuPhases.imgui, cpuPhases.upload, cpuPhases.submit, cpuPhases.sync);
+    //gpu time of the gl work
+    if (gpuTiming)
+        ImGui::Text("gpu: %.3fms", gpuTime);
+    //frame pacing, waits [poll sleep block]
+    if (pacing) {
+        const PacingStats& p = pacer.getStats();
+        ImGui::Text("pacing: latency %.3fms gpu %.3fms cpu %.3fms [%i %i %i]", p.latency, p.gpu, p.cpu, p.polls, p.sleeps, p.blocks);
+    }
+    //submission
+    ImGui::Text("draws: %i [%i] tex: %i gl: %i upload: %.1fkb", drawCalls, submits, textureBinds, glCalls, uploadBytes / 1024.f);
+    //culled upload and merged draws
+    if (commandCulling)
+        ImGui::Text("culled: %.1fkb merged: %i", culledBytes / 1024.f, mergedDraws);
+    //list cache
+    if (arenaVert != 0)
+        ImGui::Text("cache: %.0f%% saved: %.1fkb", getCacheHitRate() * 100.f, cacheSavedBytes / 1024.f);
+    //redrawn part of the retained frame
+    if (damageTracking)
+        ImGui::Text("damage: %i [%.0f%%]", (int)damageRects.size(), damageArea * 100.f);
 
     ImGui::End();
 }
 
-inline void TurboGUI::GUI::drawStats() {
+template<class Config>
+inline void TurboGUI::GUI<Config>::drawStats() {
     //draw time
     ImGui::Text("time: %.3fms [%.3fms]", drawTime, meanTime);
+    //tail latency since resetMetrics()
+    {
+        const MetricStats t = metrics.load().drawTime;
+        ImGui::Text("p50: %.3fms p99: %.3fms max: %.3fms", t.p50, t.p99, t.max);
+    }
     //vertices
     ImGui::Text("vert: %i [%i] [%i]", vert, maxVert, vertBound);
     //indices
     ImGui::Text("idx: %i [%i] [%i]", idx, maxIdx, idxBound);
     //timeout
-    ImGui::Text("sync: %i [%i] [%i]", syncTime, timeOutSync, timeOutSync - syncTime);
+    ImGui::Text("sync: %i [%i] [%i]", syncTime, timeOutSync, syncTimeOuts);
+    //frames the gpu is behind
+    ImGui::Text("frames: %i [%i]", queuedFrames, framesInFlight);
+    //startup
+    ImGui::Text("init: %.3fms [%i]", initTime, programCacheHits);
+    //cpu phases
+    ImGui::Text("cpu: imgui %.3f upload %.3f submit %.3f sync %.3f", cpuPhases.imgui, cpuPhases.upload, cpuPhases.submit, cpuPhases.sync);
+    //gpu time of the gl work
+    if (gpuTiming)
+        ImGui::Text("gpu: %.3fms", gpuTime);
+    //frame pacing, waits [poll sleep block]
+    if (pacing) {
+        const PacingStats& p = pacer.getStats();
+        ImGui::Text("pacing: latency %.3fms gpu %.3fms cpu %.3fms [%i %i %i]", p.latency, p.gpu, p.cpu, p.polls, p.sleeps, p.blocks);
+    }
+    //submission
+    ImGui::Text("draws: %i [%i] tex: %i gl: %i upload: %.1fkb", drawCalls, submits, textureBinds, glCalls, uploadBytes / 1024.f);
+    //culled upload and merged draws
+    if (commandCulling)
+        ImGui::Text("culled: %.1fkb merged: %i", culledBytes / 1024.f, mergedDraws);
+    //list cache
+    if (arenaVert != 0)
+        ImGui::Text("cache: %.0f%% saved: %.1fkb", getCacheHitRate() * 100.f, cacheSavedBytes / 1024.f);
+    //redrawn part of the retained frame
+    if (damageTracking)
+        ImGui::Text("damage: %i [%.0f%%]", (int)damageRects.size(), damageArea * 100.f);
 }
 
 